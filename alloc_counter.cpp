@@ -0,0 +1,59 @@
+#include "alloc_counter.hpp"
+
+#include <stdlib.h>
+#include <new>
+
+static thread_local uint64_t allocations = 0;
+static bool report_enabled = false;
+
+void alloc_counter_enable() {
+    report_enabled = true;
+}
+
+bool alloc_counter_enabled() {
+    return report_enabled;
+}
+
+uint64_t thread_allocations() {
+    return allocations;
+}
+
+// Remplacement des fonctions d'allocation globales (new[] et les versions
+// nothrow passent par celles-ci ; delete reste free)
+void *operator new(size_t size) {
+    allocations++;
+    void *p = malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void *operator new[](size_t size) {
+    return operator new(size);
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+    allocations++;
+    return malloc(size ? size : 1);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+    return operator new(size, std::nothrow);
+}
+
+void operator delete(void *p) noexcept {
+    free(p);
+}
+
+void operator delete[](void *p) noexcept {
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+    free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept {
+    free(p);
+}
@@ -0,0 +1,21 @@
+#ifndef ALLOC_COUNTER_HPP
+#define ALLOC_COUNTER_HPP
+
+// Compteur d'allocations sur le tas, par thread.
+//
+// operator new est remplacé pour compter les allocations du thread courant.
+// Les cv::Mat sont comptées aussi : chaque allocation de données passe par
+// new UMatData dans OpenCV. Les allocations internes de FFmpeg (av_malloc) ne
+// sont pas comptées. Sert à vérifier qu'après la première image la boucle de
+// traitement ne fait plus d'allocation (--alloc-stats).
+
+#include <stdint.h>
+
+// Active l'affichage des allocations par image à la fin de chaque vidéo
+void alloc_counter_enable();
+bool alloc_counter_enabled();
+
+// Nombre d'allocations faites par le thread courant depuis son démarrage
+uint64_t thread_allocations();
+
+#endif // ALLOC_COUNTER_HPP
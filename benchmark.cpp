@@ -0,0 +1,388 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "motion_engine.hpp"
+#include "video_reader.hpp"
+
+using namespace std;
+
+// Banc d'essai des stratégies de concurrence : chaque binaire est lancé plusieurs
+// fois sur le même dossier videos/ (en --headless, sortie standard ignorée) et
+// mesuré de l'extérieur. Temps mural (CLOCK_MONOTONIC), temps CPU et RSS maximal
+// viennent de wait4 : sous Linux, ils comprennent les processus enfants et les
+// threads de la stratégie.
+//
+// Certaines stratégies font moins de travail par défaut : multiprocessus_with_pipe et
+// multithreads_semaphore s'arrêtent au premier mouvement de chaque vidéo,
+// multiprocesssus_multithreads ne cherche pas les zones. Pour que les temps soient
+// comparables, chaque stratégie est lancée avec --full (toutes les images, extraction
+// des zones). Avec --native, elles gardent leur comportement propre : leurs lignes
+// sont marquées non comparables, sans images/s ni accélération.
+
+#define DEFAULT_RUNS 3
+
+static const char *ALL_STRATEGIES[] = {
+    "monothread",
+    "monoprocessus",
+    "multiprocessus",
+    "multiprocessus_with_pipe",
+    "multiprocesssus_multithreads",
+    "multithreads_sequenciel",
+    "multithreads_parallele",
+    "multithreads_semaphore",
+    "multithreads_sync_producer_consumer",
+};
+
+// Stratégies qui, sans --full, n'analysent pas toutes les images ou pas les zones
+static const char *PARTIAL_STRATEGIES[] = {
+    "multiprocessus_with_pipe",
+    "multiprocesssus_multithreads",
+    "multithreads_semaphore",
+};
+
+// Mesures d'une exécution
+struct RunStats {
+    double wall;   // Secondes
+    double cpu;    // Secondes utilisateur + système, enfants compris
+    long max_rss;  // Ko, processus le plus gros
+};
+
+// Résultat d'une stratégie sur toutes ses exécutions
+struct StrategyResult {
+    string name;
+    bool available;
+    bool comparable;  // Même travail que monothread (toujours vrai avec --full)
+    int failed_runs;
+    vector<RunStats> runs;
+    double wall_median;
+    double wall_min;
+    double wall_max;
+    double cpu_median;
+    long max_rss;
+};
+
+static double timeval_seconds(const struct timeval &tv) {
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+// Lance ./binary --headless args... et attend sa fin ; false si elle a échoué
+static bool run_once(const string &binary, const vector<string> &args, RunStats &stats) {
+    vector<char *> argv;
+    argv.push_back((char *)binary.c_str());
+    argv.push_back((char *)"--headless");
+    for (size_t i = 0; i < args.size(); i++) {
+        argv.push_back((char *)args[i].c_str());
+    }
+    argv.push_back(NULL);
+    string path = "./" + binary;
+
+    fflush(stdout);
+    double start = wall_time();
+    pid_t pid = fork();
+    if (pid == 0) {
+        // Sortie standard ignorée : l'affichage ne doit pas limiter le débit mesuré
+        int null_fd = open("/dev/null", O_WRONLY);
+        if (null_fd >= 0) {
+            dup2(null_fd, STDOUT_FILENO);
+            close(null_fd);
+        }
+        execv(path.c_str(), argv.data());
+        perror("Erreur lors du lancement de la stratégie");
+        _exit(127);
+    }
+    if (pid < 0) {
+        perror("Erreur lors de la création du processus");
+        return false;
+    }
+
+    int status;
+    struct rusage usage;
+    while (wait4(pid, &status, 0, &usage) < 0) {
+        if (errno != EINTR) {
+            perror("Erreur lors de l'attente de la stratégie");
+            return false;
+        }
+    }
+    stats.wall = wall_time() - start;
+    stats.cpu = timeval_seconds(usage.ru_utime) + timeval_seconds(usage.ru_stime);
+    stats.max_rss = usage.ru_maxrss;
+
+    if (WIFSIGNALED(status)) {
+        fprintf(stderr, "%s : terminé par le signal %d\n", binary.c_str(), WTERMSIG(status));
+        return false;
+    }
+    if (WEXITSTATUS(status) != 0) {
+        fprintf(stderr, "%s : code de sortie %d\n", binary.c_str(), WEXITSTATUS(status));
+        return false;
+    }
+    return true;
+}
+
+static double median(vector<double> values) {
+    sort(values.begin(), values.end());
+    size_t n = values.size();
+    return n % 2 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2;
+}
+
+static void summarize(StrategyResult &result) {
+    vector<double> walls, cpus;
+    result.max_rss = 0;
+    for (size_t i = 0; i < result.runs.size(); i++) {
+        walls.push_back(result.runs[i].wall);
+        cpus.push_back(result.runs[i].cpu);
+        result.max_rss = max(result.max_rss, result.runs[i].max_rss);
+    }
+    if (walls.empty()) {
+        return;
+    }
+    result.wall_median = median(walls);
+    result.wall_min = *min_element(walls.begin(), walls.end());
+    result.wall_max = *max_element(walls.begin(), walls.end());
+    result.cpu_median = median(cpus);
+}
+
+// Nombre d'images du jeu d'entrée, d'après les conteneurs (sans décodage)
+static int64_t count_frames(int &num_videos) {
+    int64_t frames = 0;
+    num_videos = 0;
+    DIR *dir = opendir("videos");
+    if (dir == NULL) {
+        return -1;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_type == DT_REG) {
+            char filepath[512];
+            snprintf(filepath, sizeof(filepath), "videos/%s", entry->d_name);
+            VideoReader reader;
+            if (reader.open(filepath)) {
+                frames += reader.frame_count();
+                num_videos++;
+            }
+        }
+    }
+    closedir(dir);
+    return frames;
+}
+
+static bool is_partial(const string &name) {
+    for (size_t i = 0; i < sizeof(PARTIAL_STRATEGIES) / sizeof(PARTIAL_STRATEGIES[0]); i++) {
+        if (name == PARTIAL_STRATEGIES[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static const StrategyResult *find_result(const vector<StrategyResult> &results, const char *name) {
+    for (size_t i = 0; i < results.size(); i++) {
+        if (results[i].name == name && !results[i].runs.empty()) {
+            return &results[i];
+        }
+    }
+    return NULL;
+}
+
+static void print_table(const vector<StrategyResult> &results, int64_t frames) {
+    const StrategyResult *reference = find_result(results, "monothread");
+
+    printf("\n%-38s %10s %10s %10s %10s %9s %10s\n", "Stratégie", "Mural (s)", "CPU (s)", "Images/s", "RSS (Mo)",
+           "CPU/mur", "Accél.");
+    for (size_t i = 0; i < results.size(); i++) {
+        const StrategyResult &r = results[i];
+        if (!r.available) {
+            printf("%-37s  absent (non compilé)\n", r.name.c_str());
+            continue;
+        }
+        if (r.runs.empty()) {
+            printf("%-37s  échec (%d exécution(s))\n", r.name.c_str(), r.failed_runs);
+            continue;
+        }
+        printf("%-37s %10.2f %10.2f", r.name.c_str(), r.wall_median, r.cpu_median);
+        if (r.comparable && r.wall_median > 0) {
+            printf(" %10.1f", frames / r.wall_median);
+        } else {
+            printf(" %10s", "-");
+        }
+        printf(" %10.1f %9.2f", r.max_rss / 1024.0, r.wall_median > 0 ? r.cpu_median / r.wall_median : 0.0);
+        if (r.comparable && reference && r.wall_median > 0) {
+            printf(" %9.2fx", reference->wall_median / r.wall_median);
+        } else {
+            printf(" %10s", "-");
+        }
+        if (!r.comparable) {
+            printf("  (non comparable : travail partiel)");
+        }
+        if (r.failed_runs > 0) {
+            printf("  (%d échec(s))", r.failed_runs);
+        }
+        printf("\n");
+    }
+    printf("Temps mural et CPU : médianes sur les exécutions réussies ; RSS : maximum du plus gros processus.\n");
+
+}
+
+static void json_string(FILE *out, const string &s) {
+    fputc('"', out);
+    for (size_t i = 0; i < s.size(); i++) {
+        if (s[i] == '"' || s[i] == '\\') {
+            fputc('\\', out);
+        }
+        fputc(s[i], out);
+    }
+    fputc('"', out);
+}
+
+static bool write_json(const char *path, const vector<StrategyResult> &results, int64_t frames, int num_videos,
+                       int runs, bool full, const vector<string> &args) {
+    FILE *out = fopen(path, "w");
+    if (out == NULL) {
+        perror("Erreur lors de l'ouverture du fichier JSON");
+        return false;
+    }
+    const StrategyResult *reference = find_result(results, "monothread");
+
+    fprintf(out, "{\n  \"videos\": %d,\n  \"frames\": %lld,\n  \"runs\": %d,\n  \"full\": %s,\n  \"args\": [",
+            num_videos, (long long)frames, runs, full ? "true" : "false");
+    for (size_t i = 0; i < args.size(); i++) {
+        fputs(i ? ", " : "", out);
+        json_string(out, args[i]);
+    }
+    fprintf(out, "],\n  \"strategies\": [");
+    bool first = true;
+    for (size_t i = 0; i < results.size(); i++) {
+        const StrategyResult &r = results[i];
+        if (!r.available) {
+            continue;
+        }
+        fprintf(out, "%s\n    {\"name\": ", first ? "" : ",");
+        first = false;
+        json_string(out, r.name);
+        fprintf(out, ", \"comparable\": %s, \"failed_runs\": %d, \"wall_s\": [", r.comparable ? "true" : "false",
+                r.failed_runs);
+        for (size_t j = 0; j < r.runs.size(); j++) {
+            fprintf(out, "%s%.4f", j ? ", " : "", r.runs[j].wall);
+        }
+        fprintf(out, "], \"cpu_s\": [");
+        for (size_t j = 0; j < r.runs.size(); j++) {
+            fprintf(out, "%s%.4f", j ? ", " : "", r.runs[j].cpu);
+        }
+        fprintf(out, "]");
+        if (!r.runs.empty()) {
+            fprintf(out, ", \"wall_median_s\": %.4f, \"wall_min_s\": %.4f, \"wall_max_s\": %.4f", r.wall_median,
+                    r.wall_min, r.wall_max);
+            fprintf(out, ", \"cpu_median_s\": %.4f, \"max_rss_kb\": %ld", r.cpu_median, r.max_rss);
+            if (r.comparable && r.wall_median > 0) {
+                fprintf(out, ", \"fps\": %.2f", frames / r.wall_median);
+            }
+            if (r.comparable && reference && r.wall_median > 0) {
+                fprintf(out, ", \"speedup\": %.3f", reference->wall_median / r.wall_median);
+            }
+        }
+        fprintf(out, "}");
+    }
+    fprintf(out, "\n  ]\n}\n");
+    fclose(out);
+    return true;
+}
+
+int main(int argc, char **argv) {
+    int runs = DEFAULT_RUNS;
+    bool full = true;  // --full transmis à chaque stratégie (sauf --native)
+    const char *json_path = NULL;
+    vector<string> strategies;
+    vector<string> args;  // Options transmises à chaque stratégie (après --)
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+            runs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--native") == 0) {
+            full = false;
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else if (strcmp(argv[i], "--only") == 0 && i + 1 < argc) {
+            // Liste séparée par des virgules
+            string list = argv[++i];
+            size_t start = 0;
+            while (start <= list.size()) {
+                size_t end = list.find(',', start);
+                if (end == string::npos) {
+                    end = list.size();
+                }
+                if (end > start) {
+                    strategies.push_back(list.substr(start, end - start));
+                }
+                start = end + 1;
+            }
+        } else if (strcmp(argv[i], "--") == 0) {
+            for (i++; i < argc; i++) {
+                args.push_back(argv[i]);
+            }
+        } else {
+            fprintf(stderr, "Option inconnue : %s\n", argv[i]);
+            fprintf(stderr,
+                    "Usage : %s [--runs <n>] [--only <a,b,...>] [--native] [--json <fichier>] [-- options...]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+    if (runs < 1) {
+        runs = 1;
+    }
+    if (strategies.empty()) {
+        strategies.assign(ALL_STRATEGIES, ALL_STRATEGIES + sizeof(ALL_STRATEGIES) / sizeof(ALL_STRATEGIES[0]));
+    }
+    if (find(args.begin(), args.end(), "--full") != args.end()) {
+        full = true;  // Demandé explicitement après --
+    } else if (full) {
+        args.push_back("--full");
+    }
+
+    int num_videos;
+    int64_t frames = count_frames(num_videos);
+    if (frames < 0) {
+        printf("Impossible d'ouvrir le dossier de vidéos\n");
+        return 1;
+    }
+    printf("Jeu d'entrée : %d vidéo(s), %lld images ; %d exécution(s) par stratégie, %s\n", num_videos,
+           (long long)frames, runs,
+           full ? "analyse complète (--full)" : "comportement propre de chaque stratégie (--native)");
+
+    vector<StrategyResult> results;
+    for (size_t s = 0; s < strategies.size(); s++) {
+        StrategyResult result;
+        result.name = strategies[s];
+        result.available = access(("./" + result.name).c_str(), X_OK) == 0;
+        result.comparable = full || !is_partial(result.name);
+        result.failed_runs = 0;
+        if (result.available) {
+            for (int r = 0; r < runs; r++) {
+                RunStats stats;
+                if (run_once(result.name, args, stats)) {
+                    result.runs.push_back(stats);
+                    printf("  %s, exécution %d/%d : %.2f s (CPU %.2f s)\n", result.name.c_str(), r + 1, runs,
+                           stats.wall, stats.cpu);
+                } else {
+                    result.failed_runs++;
+                }
+            }
+            summarize(result);
+        }
+        results.push_back(result);
+    }
+
+    print_table(results, frames);
+    if (json_path && !write_json(json_path, results, frames, num_videos, runs, full, args)) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,162 @@
+#include "dir_watch.hpp"
+#include "motion_engine.hpp"
+
+#include <dirent.h>
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+using namespace std;
+
+DirWatcher::DirWatcher(const char *dir) : fd_(-1), wd_(-1), wake_fd_(-1), dir_(dir) {
+    pthread_mutex_init(&lock_, NULL);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd_ < 0) {
+        fprintf(stderr, "inotify indisponible : %s\n", strerror(errno));
+        return;
+    }
+    wd_ = inotify_add_watch(fd_, dir, IN_CLOSE_WRITE | IN_MOVED_TO | IN_ONLYDIR);
+    if (wd_ < 0) {
+        fprintf(stderr, "Impossible de surveiller le dossier %s : %s\n", dir, strerror(errno));
+        close(fd_);
+        fd_ = -1;
+    }
+}
+
+DirWatcher::~DirWatcher() {
+    if (fd_ >= 0) {
+        close(fd_);  // Retire aussi la surveillance
+    }
+    if (wake_fd_ >= 0) {
+        close(wake_fd_);
+    }
+    pthread_mutex_destroy(&lock_);
+}
+
+void DirWatcher::arrived(const string &path, double now) {
+    if (queued_.count(path)) {
+        return;  // Déjà en file : l'analyse lira le dernier contenu
+    }
+    map<string, double>::iterator running = running_.find(path);
+    if (running != running_.end()) {
+        if (running->second < 0) {
+            running->second = now;  // Réécrit pendant l'analyse : remis en file par done
+        }
+        return;
+    }
+    pending_.push_back(Arrival{path, now});
+    queued_.insert(path);
+}
+
+bool DirWatcher::claim(const string &path) {
+    pthread_mutex_lock(&lock_);
+    bool claimed = !queued_.count(path) && !running_.count(path);
+    if (claimed) {
+        running_[path] = -1.0;
+    }
+    pthread_mutex_unlock(&lock_);
+    return claimed;
+}
+
+void DirWatcher::done(const string &path) {
+    pthread_mutex_lock(&lock_);
+    map<string, double>::iterator running = running_.find(path);
+    bool requeued = false;
+    if (running != running_.end()) {
+        double rewritten = running->second;
+        running_.erase(running);
+        if (rewritten >= 0) {
+            pending_.push_back(Arrival{path, rewritten});
+            queued_.insert(path);
+            requeued = true;
+        }
+    }
+    pthread_mutex_unlock(&lock_);
+    if (requeued && wake_fd_ >= 0) {
+        uint64_t one = 1;
+        if (write(wake_fd_, &one, sizeof(one)) < 0) {
+            // Compteur saturé : next est de toute façon réveillé
+        }
+    }
+}
+
+void DirWatcher::rescan(double now) {
+    DIR *dir = opendir(dir_.c_str());
+    if (!dir) {
+        return;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_type == DT_REG && entry->d_name[0] != '.') {
+            arrived(dir_ + "/" + entry->d_name, now);
+        }
+    }
+    closedir(dir);
+}
+
+void DirWatcher::read_events() {
+    // Tampon aligné pour struct inotify_event, plusieurs événements par read
+    alignas(struct inotify_event) char buffer[16 * 1024];
+    for (;;) {
+        ssize_t n = read(fd_, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return;  // EAGAIN : plus rien à lire
+        }
+        const double now = wall_time();
+        pthread_mutex_lock(&lock_);
+        for (char *p = buffer; p < buffer + n;) {
+            const struct inotify_event *event = (const struct inotify_event *)p;
+            p += sizeof(struct inotify_event) + event->len;
+            if (event->mask & IN_Q_OVERFLOW) {
+                fprintf(stderr, "File d'événements inotify pleine : relecture du dossier %s\n", dir_.c_str());
+                rescan(now);
+            } else if (event->len > 0 && !(event->mask & IN_ISDIR) && event->name[0] != '.') {
+                arrived(dir_ + "/" + event->name, now);
+            }
+        }
+        pthread_mutex_unlock(&lock_);
+    }
+}
+
+bool DirWatcher::next(string &path, double &arrival, int timeout_ms) {
+    if (fd_ < 0) {
+        return false;
+    }
+    pthread_mutex_lock(&lock_);
+    bool empty = pending_.empty();
+    pthread_mutex_unlock(&lock_);
+    if (empty) {
+        struct pollfd pfds[2] = {{fd_, POLLIN, 0}, {wake_fd_, POLLIN, 0}};
+        if (poll(pfds, wake_fd_ >= 0 ? 2 : 1, timeout_ms) <= 0) {
+            return false;  // Délai écoulé ou signal (EINTR)
+        }
+        if (wake_fd_ >= 0 && (pfds[1].revents & POLLIN)) {
+            uint64_t count;
+            if (read(wake_fd_, &count, sizeof(count)) < 0) {
+                // EAGAIN : déjà remis à zéro
+            }
+        }
+        read_events();
+    }
+
+    pthread_mutex_lock(&lock_);
+    bool found = !pending_.empty();
+    if (found) {
+        path = pending_.front().path;
+        arrival = pending_.front().time;
+        pending_.pop_front();
+        queued_.erase(path);
+        running_[path] = -1.0;
+    }
+    pthread_mutex_unlock(&lock_);
+    return found;
+}
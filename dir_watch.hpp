@@ -0,0 +1,72 @@
+#ifndef DIR_WATCH_HPP
+#define DIR_WATCH_HPP
+
+// Surveillance d'un dossier de vidéos (inotify).
+//
+// Les variantes lisent le dossier une fois avec readdir puis s'arrêtent : les
+// nouvelles vidéos demandaient de relancer le programme et de relire tout le
+// dossier. En mode service, le noyau signale chaque fichier terminé : fermé après
+// écriture (IN_CLOSE_WRITE) ou renommé dans le dossier (IN_MOVED_TO, cas des copies
+// écrites sous un nom temporaire puis renommées). Un fichier encore en cours
+// d'écriture n'est donc jamais pris. Les fichiers cachés (nom commençant par « . »,
+// fichiers temporaires de rsync par exemple) sont ignorés.
+//
+// Le dossier n'est relu en entier que si la file d'événements du noyau a débordé
+// (IN_Q_OVERFLOW) : des arrivées ont été perdues, tous les fichiers sont remis en file.
+//
+// Un fichier réécrit plusieurs fois (plusieurs IN_CLOSE_WRITE) n'est en file qu'une
+// fois : tant qu'il attend, l'analyse lira de toute façon son dernier contenu. S'il
+// est réécrit pendant son analyse, il est remis en file une seule fois, quand cette
+// analyse se termine (done).
+
+#include <pthread.h>
+
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+
+class DirWatcher {
+public:
+    explicit DirWatcher(const char *dir);
+    ~DirWatcher();
+    DirWatcher(const DirWatcher &) = delete;
+    DirWatcher &operator=(const DirWatcher &) = delete;
+
+    // false si la surveillance n'a pas pu être mise en place
+    bool ok() const { return fd_ >= 0; }
+
+    // Prochain fichier arrivé (chemin « dossier/nom ») et son heure d'arrivée (wall_time).
+    // Attend au plus timeout_ms millisecondes (< 0 : sans limite) ; false si rien n'est
+    // arrivé entre-temps ou si l'attente a été interrompue par un signal.
+    // Le fichier rendu est en cours d'analyse jusqu'à l'appel de done.
+    bool next(std::string &path, double &arrival, int timeout_ms);
+
+    // Fichier trouvé hors surveillance (lecture initiale du dossier) : en cours d'analyse
+    // jusqu'à l'appel de done. false s'il est déjà en file ou en cours d'analyse.
+    bool claim(const std::string &path);
+
+    // Fin de l'analyse d'un fichier rendu par next ou claim (appelable depuis un autre thread)
+    void done(const std::string &path);
+
+private:
+    struct Arrival {
+        std::string path;
+        double time;
+    };
+
+    void read_events();
+    void rescan(double now);
+    void arrived(const std::string &path, double now);  // Appelée avec lock_ pris
+
+    int fd_;
+    int wd_;
+    int wake_fd_;  // eventfd : réveille next quand done remet un fichier en file
+    std::string dir_;
+    pthread_mutex_t lock_;
+    std::deque<Arrival> pending_;
+    std::set<std::string> queued_;          // Chemins dans pending_
+    std::map<std::string, double> running_; // En cours d'analyse -> heure de la réécriture (< 0 : aucune)
+};
+
+#endif // DIR_WATCH_HPP
@@ -0,0 +1,394 @@
+#include "event_log.hpp"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <atomic>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#define EVENT_BUFFER_SIZE 4096  // Événements par thread (puissance de 2)
+#define WRITER_PERIOD_MS 10     // Attente maximale du thread d'écriture entre deux lots
+
+// Usage d'un tampon de la liste
+enum BufferState {
+    BUFFER_THREAD,    // Tampon d'un thread (event_log_push)
+    BUFFER_CHANNEL,   // Canal d'une vidéo en cours
+    BUFFER_RETIRED,   // Canal fermé, peut-être pas encore vidé
+    BUFFER_FREE       // Canal vidé, réutilisable par event_log_channel_open
+};
+
+// Tampon circulaire d'un thread ou d'un canal : head avancé par le producteur, tail par le
+// thread d'écriture
+struct ThreadBuffer {
+    MotionEvent events[EVENT_BUFFER_SIZE];
+    atomic<uint32_t> head;
+    atomic<uint32_t> tail;
+    atomic<int> state;
+    ThreadBuffer *next;  // Liste des tampons, parcourue par le thread d'écriture
+};
+
+struct EventChannel : ThreadBuffer {};
+
+static atomic<ThreadBuffer *> buffers(nullptr);
+static atomic<unsigned> generation(0);  // Change à chaque ouverture : les anciens tampons sont invalides
+static atomic<bool> opened(false);
+
+// Canaux vidés, prêts à être réutilisés (tampons jamais retirés de la liste avant la fermeture)
+static pthread_mutex_t channels_lock = PTHREAD_MUTEX_INITIALIZER;
+static vector<EventChannel *> free_channels;
+
+static thread_local ThreadBuffer *local_buffer = nullptr;
+static thread_local unsigned local_generation = 0;
+
+// Chemins des vidéos, indexés par identifiant (conservés pendant tout le programme)
+static pthread_mutex_t names_lock = PTHREAD_MUTEX_INITIALIZER;
+static vector<string> names;
+static map<string, uint32_t> name_ids;
+
+static pthread_t writer_thread;
+static pthread_mutex_t writer_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t writer_cond = PTHREAD_COND_INITIALIZER;
+static bool writer_stop = false;
+static FILE *out = NULL;
+static bool out_binary = false;
+
+EventLogOptions parse_event_log_options(int argc, char **argv) {
+    EventLogOptions options;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--events") == 0 && i + 1 < argc) {
+            options.path = argv[++i];
+        } else if (strcmp(argv[i], "--events-binary") == 0) {
+            options.binary = true;
+        }
+    }
+    return options;
+}
+
+uint32_t event_log_video(const char *video_path) {
+    static thread_local string last_path;
+    static thread_local uint32_t last_id = 0;
+    if (!last_path.empty() && last_path == video_path) {
+        return last_id;
+    }
+
+    pthread_mutex_lock(&names_lock);
+    map<string, uint32_t>::iterator it = name_ids.find(video_path);
+    if (it == name_ids.end()) {
+        it = name_ids.insert(make_pair(string(video_path), (uint32_t)names.size())).first;
+        names.push_back(video_path);
+    }
+    last_id = it->second;
+    pthread_mutex_unlock(&names_lock);
+
+    last_path = video_path;
+    return last_id;
+}
+
+static void wake_writer() {
+    pthread_mutex_lock(&writer_lock);
+    pthread_cond_signal(&writer_cond);
+    pthread_mutex_unlock(&writer_lock);
+}
+
+// Nouveau tampon ajouté à la liste (sans verrou)
+static void link_buffer(ThreadBuffer *buffer, BufferState state) {
+    buffer->head.store(0);
+    buffer->tail.store(0);
+    buffer->state.store(state);
+    buffer->next = buffers.load();
+    while (!buffers.compare_exchange_weak(buffer->next, buffer)) {
+    }
+}
+
+static void push_to(ThreadBuffer *buffer, const MotionEvent &event) {
+    uint32_t head = buffer->head.load(memory_order_relaxed);
+    while (head - buffer->tail.load(memory_order_acquire) == EVENT_BUFFER_SIZE) {
+        wake_writer();  // Tampon plein : attendre le prochain lot
+        sched_yield();
+    }
+    buffer->events[head & (EVENT_BUFFER_SIZE - 1)] = event;
+    buffer->head.store(head + 1, memory_order_release);
+
+    if (head - buffer->tail.load(memory_order_relaxed) == EVENT_BUFFER_SIZE / 2) {
+        wake_writer();  // À moitié plein : ne pas attendre la fin de la période
+    }
+}
+
+void event_log_push(const MotionEvent &event) {
+    if (!opened.load(memory_order_acquire)) {
+        return;
+    }
+
+    unsigned gen = generation.load(memory_order_acquire);
+    if (!local_buffer || local_generation != gen) {
+        // Premier événement du thread : nouveau tampon
+        local_buffer = new ThreadBuffer;
+        link_buffer(local_buffer, BUFFER_THREAD);
+        local_generation = gen;
+    }
+    push_to(local_buffer, event);
+}
+
+EventChannel *event_log_channel_open() {
+    if (!opened.load(memory_order_acquire)) {
+        return nullptr;
+    }
+    EventChannel *channel = nullptr;
+    pthread_mutex_lock(&channels_lock);
+    if (!free_channels.empty()) {
+        channel = free_channels.back();
+        free_channels.pop_back();
+    }
+    pthread_mutex_unlock(&channels_lock);
+    if (channel) {
+        channel->state.store(BUFFER_CHANNEL, memory_order_relaxed);
+    } else {
+        channel = new EventChannel;
+        link_buffer(channel, BUFFER_CHANNEL);
+    }
+    return channel;
+}
+
+void event_log_channel_push(EventChannel *channel, const MotionEvent &event) {
+    if (channel) {
+        push_to(channel, event);
+    }
+}
+
+void event_log_channel_close(EventChannel *channel) {
+    if (channel) {
+        channel->state.store(BUFFER_RETIRED, memory_order_release);  // Après le dernier ajout
+        wake_writer();
+    }
+}
+
+// Ajoute un événement au lot, au format choisi
+static void format_event(const MotionEvent &event, vector<char> &batch, vector<string> &known, size_t &announced) {
+    if (event.video >= known.size()) {
+        pthread_mutex_lock(&names_lock);
+        known.assign(names.begin(), names.end());
+        pthread_mutex_unlock(&names_lock);
+    }
+    const string &name = known[event.video];
+
+    if (out_binary) {
+        // Annoncer les vidéos pas encore écrites avant leur premier événement
+        while (announced <= event.video) {
+            MotionEvent video = {EVENT_VIDEO, 0, (uint32_t)announced, 0, (int32_t)known[announced].size(), 0, 0};
+            batch.insert(batch.end(), (const char *)&video, (const char *)(&video + 1));
+            batch.insert(batch.end(), known[announced].begin(), known[announced].end());
+            announced++;
+        }
+        batch.insert(batch.end(), (const char *)&event, (const char *)(&event + 1));
+        return;
+    }
+
+    char line[640];
+    int n = 0;
+    if (event.kind == EVENT_PIXELS) {
+        n = snprintf(line, sizeof(line), "Mouvement détecté dans %s, Nombre de pixels affectés : %d\n", name.c_str(), event.value);
+    } else if (event.kind == EVENT_REGION) {
+        n = snprintf(line, sizeof(line), "Mouvement détecté dans %s à la position : (%d, %d)\n", name.c_str(), event.x, event.y);
+    }
+    if (n > (int)sizeof(line) - 1) {
+        n = sizeof(line) - 1;
+    }
+    batch.insert(batch.end(), line, line + n);
+}
+
+// Vide tous les tampons dans un lot puis l'écrit en un seul appel ; retourne le nombre d'événements
+static size_t drain(vector<char> &batch, vector<string> &known, size_t &announced) {
+    size_t count = 0;
+    batch.clear();
+    for (ThreadBuffer *buffer = buffers.load(memory_order_acquire); buffer; buffer = buffer->next) {
+        // État lu avant head : un canal fermé a alors publié tous ses événements
+        const int state = buffer->state.load(memory_order_acquire);
+        uint32_t tail = buffer->tail.load(memory_order_relaxed);
+        uint32_t head = buffer->head.load(memory_order_acquire);
+        for (; tail != head; tail++) {
+            format_event(buffer->events[tail & (EVENT_BUFFER_SIZE - 1)], batch, known, announced);
+            count++;
+        }
+        buffer->tail.store(tail, memory_order_release);
+        if (state == BUFFER_RETIRED) {
+            buffer->state.store(BUFFER_FREE, memory_order_relaxed);
+            pthread_mutex_lock(&channels_lock);
+            free_channels.push_back((EventChannel *)buffer);
+            pthread_mutex_unlock(&channels_lock);
+        }
+    }
+    if (!batch.empty()) {
+        fwrite(batch.data(), 1, batch.size(), out);
+        fflush(out);
+    }
+    return count;
+}
+
+static void *writer_main(void *arg) {
+    (void)arg;
+    vector<char> batch;
+    vector<string> known;
+    size_t announced = 0;
+
+    for (;;) {
+        if (drain(batch, known, announced) > 0) {
+            continue;
+        }
+
+        pthread_mutex_lock(&writer_lock);
+        if (writer_stop) {
+            pthread_mutex_unlock(&writer_lock);
+            break;
+        }
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += WRITER_PERIOD_MS * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(&writer_cond, &writer_lock, &deadline);
+        pthread_mutex_unlock(&writer_lock);
+    }
+
+    drain(batch, known, announced);  // Derniers événements ajoutés avant l'arrêt
+    return NULL;
+}
+
+bool event_log_open(const EventLogOptions &options) {
+    if (opened.load()) {
+        return true;
+    }
+
+    out = options.path ? fopen(options.path, "wb") : stdout;
+    if (!out) {
+        fprintf(stderr, "Erreur lors de l'ouverture du journal %s\n", options.path);
+        return false;
+    }
+    out_binary = options.binary;
+    if (out_binary) {
+        fwrite(EVENT_LOG_MAGIC, 1, 8, out);
+    }
+
+    writer_stop = false;
+    generation++;
+    if (pthread_create(&writer_thread, NULL, writer_main, NULL) != 0) {
+        perror("Erreur lors de la création du thread d'écriture");
+        if (out != stdout) {
+            fclose(out);
+        }
+        return false;
+    }
+    opened.store(true, memory_order_release);
+    return true;
+}
+
+void event_log_close() {
+    if (!opened.exchange(false)) {
+        return;
+    }
+
+    pthread_mutex_lock(&writer_lock);
+    writer_stop = true;
+    pthread_cond_signal(&writer_cond);
+    pthread_mutex_unlock(&writer_lock);
+    pthread_join(writer_thread, NULL);
+
+    // Les threads d'analyse sont terminés : les tampons peuvent être libérés
+    pthread_mutex_lock(&channels_lock);
+    free_channels.clear();
+    pthread_mutex_unlock(&channels_lock);
+    ThreadBuffer *buffer = buffers.exchange(nullptr);
+    while (buffer) {
+        ThreadBuffer *next = buffer->next;
+        delete buffer;
+        buffer = next;
+    }
+
+    if (out != stdout) {
+        fclose(out);
+    } else {
+        fflush(out);
+    }
+    out = NULL;
+}
+
+EventLogSink::EventLogSink(bool log_pixels, bool log_positions, bool per_video)
+    : log_pixels_(log_pixels), log_positions_(log_positions), per_video_(per_video) {
+    pthread_mutex_init(&lock_, NULL);
+}
+
+EventLogSink::~EventLogSink() {
+    pthread_mutex_destroy(&lock_);  // Canaux encore ouverts : libérés par event_log_close
+}
+
+void EventLogSink::begin_video(const char *video_path) {
+    if (!per_video_) {
+        return;
+    }
+    EventChannel *channel = event_log_channel_open();
+    pthread_mutex_lock(&lock_);
+    channels_[event_log_video(video_path)] = channel;
+    pthread_mutex_unlock(&lock_);
+}
+
+void EventLogSink::end_video(const char *video_path, bool movement_detected) {
+    (void)movement_detected;
+    if (!per_video_) {
+        return;
+    }
+    EventChannel *channel = nullptr;
+    pthread_mutex_lock(&lock_);
+    map<uint32_t, EventChannel *>::iterator it = channels_.find(event_log_video(video_path));
+    if (it != channels_.end()) {
+        channel = it->second;
+        channels_.erase(it);
+    }
+    pthread_mutex_unlock(&lock_);
+    event_log_channel_close(channel);
+}
+
+void EventLogSink::push(uint32_t video, const MotionEvent &event) {
+    if (!per_video_) {
+        event_log_push(event);
+        return;
+    }
+    pthread_mutex_lock(&lock_);
+    map<uint32_t, EventChannel *>::iterator it = channels_.find(video);
+    EventChannel *channel = it != channels_.end() ? it->second : nullptr;
+    pthread_mutex_unlock(&lock_);
+    if (channel) {
+        event_log_channel_push(channel, event);
+    } else {
+        event_log_push(event);  // Vidéo sans begin_video : tampon du thread
+    }
+}
+
+bool EventLogSink::on_frame(const char *video_path, cv::Mat &frame, const FrameResult &result) {
+    (void)frame;
+    if (result.movement_pixels <= 0) {
+        return true;
+    }
+
+    const uint32_t video = event_log_video(video_path);
+    MotionEvent event = {EVENT_PIXELS, 0, video, result.frame_index, result.movement_pixels, 0, 0};
+    if (log_pixels_) {
+        push(video, event);
+    }
+    if (log_positions_) {
+        event.kind = EVENT_REGION;
+        for (size_t i = 0; i < result.regions.size(); i++) {
+            event.value = (int32_t)result.regions[i].area;
+            event.x = result.regions[i].center.x;
+            event.y = result.regions[i].center.y;
+            push(video, event);
+        }
+    }
+    return true;
+}
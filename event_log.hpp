@@ -0,0 +1,97 @@
+#ifndef EVENT_LOG_HPP
+#define EVENT_LOG_HPP
+
+// Journal asynchrone des événements de mouvement.
+//
+// Les threads d'analyse ne formatent ni n'écrivent rien : chaque événement est
+// copié dans un tampon circulaire propre au thread (sans verrou, un seul
+// producteur et un seul lecteur). Un thread d'écriture vide tous les tampons par
+// lots et écrit chaque lot en un seul appel, en texte (mêmes lignes que
+// ConsoleSink) ou dans un format binaire compact.
+//
+// Format binaire : l'en-tête EVENT_LOG_MAGIC (8 octets) puis une suite de
+// MotionEvent. Un événement EVENT_VIDEO est suivi des value octets du chemin de
+// la vidéo et précède tous les événements de cette vidéo.
+
+#include "motion_engine.hpp"
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include <map>
+
+#define EVENT_LOG_MAGIC "MEVLOG1\n"
+
+enum EventKind {
+    EVENT_VIDEO = 1,   // Nouvelle vidéo : value = longueur du chemin qui suit
+    EVENT_PIXELS = 2,  // Image avec mouvement : value = nombre de pixels en mouvement
+    EVENT_REGION = 3   // Zone de mouvement : value = aire, (x, y) = centre
+};
+
+// Événement de mouvement (24 octets, ordre des octets de la machine)
+struct MotionEvent {
+    uint16_t kind;
+    uint16_t reserved;
+    uint32_t video;    // Identifiant de la vidéo (event_log_video)
+    int32_t frame;
+    int32_t value;
+    int32_t x, y;
+};
+
+// Destination du journal, choisie en ligne de commande
+struct EventLogOptions {
+    const char *path = nullptr;  // --events <fichier> (NULL : sortie standard)
+    bool binary = false;         // --events-binary
+};
+
+EventLogOptions parse_event_log_options(int argc, char **argv);
+
+// Démarre le thread d'écriture ; retourne false si le fichier ne peut pas être ouvert
+bool event_log_open(const EventLogOptions &options);
+
+// Écrit les événements restants puis arrête le thread d'écriture
+void event_log_close();
+
+// Identifiant d'une vidéo pour les événements (une entrée par chemin). Le dernier
+// chemin de chaque thread est gardé en cache : le verrou n'est pris qu'au changement de vidéo.
+uint32_t event_log_video(const char *video_path);
+
+// Ajoute un événement au tampon du thread courant. Si le tampon est plein, le
+// thread attend que le thread d'écriture l'ait vidé (aucun événement perdu).
+// Sans journal ouvert, l'événement est ignoré.
+void event_log_push(const MotionEvent &event);
+
+// Tampon propre à une vidéo plutôt qu'au thread. Quand les images d'une vidéo sont
+// transmises à tour de rôle par plusieurs threads (vidéo découpée en segments, cf.
+// video_segments.hpp), ses événements iraient dans plusieurs tampons, vidés l'un après
+// l'autre par le thread d'écriture : l'ordre des images serait perdu. Les ajouts dans un
+// même canal doivent être sérialisés par l'appelant. Sans journal ouvert : NULL, ignoré.
+struct EventChannel;
+EventChannel *event_log_channel_open();
+void event_log_channel_push(EventChannel *channel, const MotionEvent &event);
+// Plus d'ajout : le tampon est réutilisé une fois vidé par le thread d'écriture
+void event_log_channel_close(EventChannel *channel);
+
+// Sortie qui envoie les résultats au journal au lieu de les afficher directement
+// (mêmes options que ConsoleSink). Peut être partagée entre threads. Avec per_video,
+// chaque vidéo a son propre canal entre begin_video et end_video (vidéos découpées en
+// segments) ; sinon les événements passent par le tampon du thread appelant.
+class EventLogSink : public MotionSink {
+public:
+    EventLogSink(bool log_pixels, bool log_positions, bool per_video = false);
+    ~EventLogSink();
+    void begin_video(const char *video_path) override;
+    bool on_frame(const char *video_path, cv::Mat &frame, const FrameResult &result) override;
+    void end_video(const char *video_path, bool movement_detected) override;
+
+private:
+    void push(uint32_t video, const MotionEvent &event);
+
+    bool log_pixels_;
+    bool log_positions_;
+    bool per_video_;
+    pthread_mutex_t lock_;                        // Protège channels_
+    std::map<uint32_t, EventChannel *> channels_; // Canal de chaque vidéo en cours (per_video)
+};
+
+#endif // EVENT_LOG_HPP
@@ -0,0 +1,46 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <opencv2/opencv.hpp>
+#include "synthetic_video.hpp"
+
+using namespace cv;
+
+// Génère une vidéo synthétique reproductible (cf. synthetic_video.hpp) :
+//   ./generate_videos --resolution 1080p --fps 30 --frames 300 --objects 3 --noise 4 --seed 1 --out videos/synth.avi
+// --codec <fourcc> choisit le codec (MJPG par défaut, FFV1 pour une vidéo sans perte)
+
+int main(int argc, char **argv) {
+    SyntheticConfig config = parse_synthetic_config(argc, argv);
+    const char *out_path = "synthetic.avi";
+    const char *codec = "MJPG";
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--out") == 0) {
+            out_path = argv[++i];
+        } else if (strcmp(argv[i], "--codec") == 0) {
+            codec = argv[++i];
+        }
+    }
+    if (strlen(codec) != 4) {
+        fprintf(stderr, "Codec invalide %s (quatre caractères attendus)\n", codec);
+        return 1;
+    }
+
+    VideoWriter writer(out_path, VideoWriter::fourcc(codec[0], codec[1], codec[2], codec[3]), config.fps,
+                       Size(config.width, config.height));
+    if (!writer.isOpened()) {
+        fprintf(stderr, "Impossible de créer la vidéo %s\n", out_path);
+        return 1;
+    }
+
+    SyntheticScene scene(config);
+    Mat frame;
+    for (int i = 0; i < config.frames; i++) {
+        scene.render(i, frame);
+        writer.write(frame);
+    }
+
+    printf("%s : %dx%d, %.2f images/s, %d images, %d objet(s), bruit %.1f, graine %llu\n", out_path, config.width,
+           config.height, config.fps, config.frames, config.objects, config.noise, (unsigned long long)config.seed);
+    return 0;
+}
@@ -0,0 +1,250 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "motion_engine.hpp"
+#include "motion_kernels.hpp"
+#include "synthetic_video.hpp"
+
+using namespace cv;
+using namespace std;
+
+// Microbenchmarks par étape du détecteur, de 480p à 4K, sur deux images
+// successives d'une scène synthétique (cf. synthetic_video.hpp) :
+//   ./microbench --iterations 50 --objects 3 --noise 4 --resolutions 480p,1080p,4k --json stages.json
+// Chaque étape est chronométrée seule (médiane en millisecondes par image), pour
+// voir où part le temps et repérer une régression étape par étape.
+
+#define DEFAULT_ITERATIONS 50
+#define DEFAULT_RESOLUTIONS "480p,720p,1080p,1440p,4k"
+
+// Données partagées par les étapes : deux images successives et les sorties de chaque étape
+struct StageInput {
+    Mat frame, prev_frame;  // BGR
+    Mat gray, prev_gray;
+    Mat diff, mask, fused_mask, fused_gray;
+    Mat canvas;
+    int threshold;
+    ContourExtractor contours;
+    ComponentExtractor components;
+    FrameResult result;
+};
+
+struct Stage {
+    const char *name;
+    void (*prepare)(StageInput &in);  // Hors chronomètre (peut être NULL)
+    void (*run)(StageInput &in);
+};
+
+static void stage_gray(StageInput &in) {
+    cvtColor(in.frame, in.gray, COLOR_BGR2GRAY);
+}
+
+static void stage_absdiff(StageInput &in) {
+    absdiff(in.gray, in.prev_gray, in.diff);
+}
+
+static void stage_threshold(StageInput &in) {
+    threshold(in.diff, in.mask, in.threshold, 255, THRESH_BINARY);
+}
+
+static volatile int sink_count;  // Empêche le compilateur d'ignorer countNonZero
+
+static void stage_count(StageInput &in) {
+    sink_count = countNonZero(in.mask);
+}
+
+static void stage_fused_luma(StageInput &in) {
+    sink_count = fused_motion_luma(in.gray, in.prev_gray, in.fused_mask, in.threshold);
+}
+
+static void stage_fused_bgr(StageInput &in) {
+    sink_count = fused_motion(in.frame, in.prev_gray, in.fused_gray, in.fused_mask, in.threshold);
+}
+
+static void clear_result(StageInput &in) {
+    in.result.regions.clear();
+    in.result.contours = nullptr;
+}
+
+static void stage_contours(StageInput &in) {
+    in.contours.extract(in.mask, in.result);
+}
+
+static void stage_components(StageInput &in) {
+    in.components.extract(in.mask, in.result);
+}
+
+static void prepare_draw(StageInput &in) {
+    // Zones et contours de l'image courante, sur une copie neuve de l'image
+    clear_result(in);
+    in.contours.extract(in.mask, in.result);
+    in.frame.copyTo(in.canvas);
+}
+
+static void stage_draw(StageInput &in) {
+    draw_motion(in.canvas, in.result);
+}
+
+static const Stage STAGES[] = {
+    {"gray (cvtColor)", NULL, stage_gray},
+    {"absdiff", NULL, stage_absdiff},
+    {"threshold", NULL, stage_threshold},
+    {"countNonZero", NULL, stage_count},
+    {"fused_motion_luma", NULL, stage_fused_luma},
+    {"fused_motion (BGR)", NULL, stage_fused_bgr},
+    {"contours + moments", clear_result, stage_contours},
+    {"components", clear_result, stage_components},
+    {"draw_motion", prepare_draw, stage_draw},
+};
+#define NUM_STAGES (sizeof(STAGES) / sizeof(STAGES[0]))
+
+struct ResolutionResult {
+    string name;
+    int width, height;
+    int regions;             // Zones trouvées (pour vérifier que la scène bouge)
+    double ms[NUM_STAGES];   // Médiane par étape
+};
+
+static double median(vector<double> values) {
+    sort(values.begin(), values.end());
+    size_t n = values.size();
+    return n % 2 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2;
+}
+
+static void run_resolution(const SyntheticConfig &base, const char *name, int iterations, int threshold,
+                           ResolutionResult &out) {
+    SyntheticConfig config = base;
+    parse_resolution(name, config.width, config.height);
+    out.name = name;
+    out.width = config.width;
+    out.height = config.height;
+
+    StageInput in;
+    in.threshold = threshold;
+    SyntheticScene scene(config);
+    scene.render(0, in.prev_frame);
+    scene.render(1, in.frame);
+    cvtColor(in.prev_frame, in.prev_gray, COLOR_BGR2GRAY);
+
+    // Les étapes sont enchaînées dans l'ordre une première fois (tampons alloués, entrées des suivantes)
+    for (size_t s = 0; s < NUM_STAGES; s++) {
+        if (STAGES[s].prepare) {
+            STAGES[s].prepare(in);
+        }
+        STAGES[s].run(in);
+    }
+    out.regions = (int)in.result.regions.size();
+
+    vector<double> times(iterations);
+    for (size_t s = 0; s < NUM_STAGES; s++) {
+        for (int i = 0; i < iterations; i++) {
+            if (STAGES[s].prepare) {
+                STAGES[s].prepare(in);
+            }
+            double start = wall_time();
+            STAGES[s].run(in);
+            times[i] = (wall_time() - start) * 1000.0;
+        }
+        out.ms[s] = median(times);
+    }
+}
+
+static void print_table(const vector<ResolutionResult> &results) {
+    printf("\n%-22s", "Étape (ms / image)");
+    for (size_t r = 0; r < results.size(); r++) {
+        printf(" %11s", results[r].name.c_str());
+    }
+    printf("\n");
+    for (size_t s = 0; s < NUM_STAGES; s++) {
+        printf("%-21s", STAGES[s].name);
+        for (size_t r = 0; r < results.size(); r++) {
+            printf(" %11.3f", results[r].ms[s]);
+        }
+        printf("\n");
+    }
+    printf("%-21s", "zones trouvées");
+    for (size_t r = 0; r < results.size(); r++) {
+        printf(" %11d", results[r].regions);
+    }
+    printf("\n");
+}
+
+static bool write_json(const char *path, const vector<ResolutionResult> &results, const SyntheticConfig &config,
+                       int iterations, int threshold) {
+    FILE *out = fopen(path, "w");
+    if (out == NULL) {
+        perror("Erreur lors de l'ouverture du fichier JSON");
+        return false;
+    }
+    fprintf(out, "{\n  \"isa\": \"%s\",\n  \"iterations\": %d,\n  \"threshold\": %d,\n", fused_motion_isa(),
+            iterations, threshold);
+    fprintf(out, "  \"objects\": %d,\n  \"noise\": %.2f,\n  \"seed\": %llu,\n  \"resolutions\": [", config.objects,
+            config.noise, (unsigned long long)config.seed);
+    for (size_t r = 0; r < results.size(); r++) {
+        const ResolutionResult &res = results[r];
+        fprintf(out, "%s\n    {\"name\": \"%s\", \"width\": %d, \"height\": %d, \"regions\": %d, \"ms\": {",
+                r ? "," : "", res.name.c_str(), res.width, res.height, res.regions);
+        for (size_t s = 0; s < NUM_STAGES; s++) {
+            fprintf(out, "%s\"%s\": %.4f", s ? ", " : "", STAGES[s].name, res.ms[s]);
+        }
+        fprintf(out, "}}");
+    }
+    fprintf(out, "\n  ]\n}\n");
+    fclose(out);
+    return true;
+}
+
+int main(int argc, char **argv) {
+    SyntheticConfig config = parse_synthetic_config(argc, argv);
+    MotionConfig motion_config = parse_motion_config(argc, argv);
+    int iterations = DEFAULT_ITERATIONS;
+    string resolutions = DEFAULT_RESOLUTIONS;
+    const char *json_path = NULL;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--iterations") == 0) {
+            iterations = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--resolutions") == 0) {
+            resolutions = argv[++i];
+        } else if (strcmp(argv[i], "--json") == 0) {
+            json_path = argv[++i];
+        }
+    }
+    if (iterations < 1) {
+        iterations = 1;
+    }
+
+    printf("Noyaux fusionnés : %s ; %d itération(s) par étape, %d objet(s), bruit %.1f\n", fused_motion_isa(),
+           iterations, config.objects, config.noise);
+
+    vector<ResolutionResult> results;
+    size_t start = 0;
+    while (start <= resolutions.size()) {
+        size_t end = resolutions.find(',', start);
+        if (end == string::npos) {
+            end = resolutions.size();
+        }
+        string name = resolutions.substr(start, end - start);
+        start = end + 1;
+        int width, height;
+        if (name.empty()) {
+            continue;
+        }
+        if (!parse_resolution(name.c_str(), width, height)) {
+            fprintf(stderr, "Résolution invalide %s, ignorée\n", name.c_str());
+            continue;
+        }
+        ResolutionResult result;
+        run_resolution(config, name.c_str(), iterations, motion_config.threshold, result);
+        results.push_back(result);
+    }
+
+    print_table(results);
+    if (json_path && !write_json(json_path, results, config, iterations, motion_config.threshold)) {
+        return 1;
+    }
+    return 0;
+}
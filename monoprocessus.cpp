@@ -4,67 +4,38 @@
 #include <string.h>
 #include <opencv2/opencv.hpp>
 #include <time.h>
+#include "motion_engine.hpp"
 
 using namespace cv;
 using namespace std; // Add this line to use the standard library containers
 
+// Sorties visuelles choisies en ligne de commande (--headless, --annotate <dossier>)
+static OutputOptions output_options;
+
+// Paramètres du détecteur choisis en ligne de commande (cf. parse_motion_config)
+static MotionConfig motion_config;
+
 // Fonction pour détecter les mouvements et afficher la position
 int detect_movement(const char *video_path) {
     printf("Traitement de la vidéo : %s\n", video_path);
-    VideoCapture cap(video_path);
-    if (!cap.isOpened()) {
-        fprintf(stderr, "Erreur lors de l'ouverture de la vidéo %s\n", video_path);
-        return -1;
-    }
-
-    Mat frame, gray, prev_gray, diff, thresh, contours_img;
-    bool first_frame = true;
-
-    while (cap.read(frame)) {
-        cvtColor(frame, gray, COLOR_BGR2GRAY);  // Conversion en niveaux de gris
-
-        if (!first_frame) {
-            absdiff(prev_gray, gray, diff);  // Différence absolue entre les images
-            threshold(diff, thresh, 25, 255, THRESH_BINARY);  // Seuil pour détecter les changements
-            
-            // Trouver les contours dans l'image binaire
-            vector<vector<Point>> contours;  // Use std::vector
-            findContours(thresh, contours, RETR_EXTERNAL, CHAIN_APPROX_SIMPLE);
-
-            for (size_t i = 0; i < contours.size(); i++) {
-                // Calculer le rectangle englobant pour chaque contour
-                Rect bounding_box = boundingRect(contours[i]);
 
-                // Calculer le centre du rectangle (mouvement détecté)
-                Point center = (bounding_box.br() + bounding_box.tl()) * 0.5;
+    MotionConfig config = motion_config;
+    config.centroid = CENTROID_BOUNDING_BOX;  // Centre du rectangle englobant
+    MotionDetector detector(config);
 
-                // Afficher les coordonnées du centre du mouvement détecté dans la console
-                printf("Mouvement détecté à la position (x, y) : (%d, %d)\n", center.x, center.y);
+    ConsoleSink printer(false, true);
+    AnnotationSink annotation(output_options);
+    SinkChain sinks;
+    sinks.add(&printer);
+    sinks.add(&annotation);
 
-                // Dessiner le contour et le centre sur l'image pour visualiser
-                drawContours(frame, contours, (int)i, Scalar(0, 255, 0), 2); // Contour en vert
-                circle(frame, center, 5, Scalar(0, 0, 255), -1);  // Centre en rouge
-
-                // Ajouter du texte avec les coordonnées du centre
-                char text[50];
-                snprintf(text, sizeof(text), "Pos: (%d, %d)", center.x, center.y);
-                putText(frame, text, center, FONT_HERSHEY_SIMPLEX, 0.7, Scalar(255, 0, 0), 2);
-            }
-        }
-
-        imshow("Mouvement Détecté", frame);  // Afficher l'image avec les contours et le centre
-        if (waitKey(30) >= 0) break;  // Sortir si une touche est pressée
-
-        gray.copyTo(prev_gray);  // Sauvegarder l'image actuelle pour la comparaison suivante
-        first_frame = false;
-    }
-
-    cap.release();
-    return 0;
+    return run_video(video_path, detector, &sinks) < 0 ? -1 : 0;
 }
 
-int main() {
-    clock_t start_time = clock();
+int main(int argc, char **argv) {
+    double start_time = wall_time();
+    output_options = parse_output_options(argc, argv);
+    motion_config = parse_motion_config(argc, argv);
 
     struct dirent *entry;
     DIR *dir = opendir("videos");
@@ -97,8 +68,7 @@ int main() {
 
     free(video_files);  // Libérer le tableau des chemins vidéo
 
-    clock_t end_time = clock();
-    double elapsed_time = ((double)(end_time - start_time)) / CLOCKS_PER_SEC;
+    double elapsed_time = wall_time() - start_time;
     printf("Temps total d'exécution (MonoProcessus) : %.2f secondes\n", elapsed_time);
 
     return 0;
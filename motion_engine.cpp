@@ -0,0 +1,712 @@
+#include "motion_engine.hpp"
+#include "alloc_counter.hpp"
+#include "motion_kernels.hpp"
+#include "result_cache.hpp"
+#include "video_io.hpp"
+#include "video_reader.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+using namespace cv;
+using namespace std;
+
+#define COARSE_TILE 64  // Côté des tuiles pleine résolution du mode pyramide (pixels)
+
+void ContourExtractor::extract(const Mat &mask, FrameResult &result) {
+    // Masque éventuellement restreint à une zone (ROI) : coordonnées dans l'image complète
+    Size whole;
+    Point offset;
+    mask.locateROI(whole, offset);
+
+    // findContours ne modifie plus son entrée depuis OpenCV 3.2
+    findContours(mask, contours_, RETR_EXTERNAL, CHAIN_APPROX_SIMPLE, offset);
+    result.contours = &contours_;
+
+    for (size_t i = 0; i < contours_.size(); i++) {
+        MotionRegion region;
+        region.box = boundingRect(contours_[i]);
+        region.contour = (int)i;
+
+        if (method_ == CENTROID_MOMENTS) {
+            Moments m = moments(contours_[i]);
+            if (m.m00 <= 0) {
+                continue;  // Contour d'aire nulle : pas de centre de masse
+            }
+            region.area = m.m00;
+            region.center = Point(static_cast<int>(m.m10 / m.m00), static_cast<int>(m.m01 / m.m00));
+        } else {
+            region.area = region.box.area();
+            region.center = (region.box.br() + region.box.tl()) * 0.5;
+        }
+        if (region.area < min_area_) {
+            continue;
+        }
+        result.regions.push_back(region);
+    }
+}
+
+int ComponentExtractor::find_root(int label) {
+    while (parent_[label] != label) {
+        parent_[label] = parent_[parent_[label]];  // Compression de chemin par moitié
+        label = parent_[label];
+    }
+    return label;
+}
+
+// Premier octet non nul de row[x, width[ (width si aucun), 8 octets à la fois sur les zones vides
+static int next_set(const uchar *row, int x, int width) {
+    while (x + 8 <= width) {
+        uint64_t word;
+        memcpy(&word, row + x, sizeof(word));
+        if (word) {
+            break;
+        }
+        x += 8;
+    }
+    while (x < width && !row[x]) {
+        x++;
+    }
+    return x;
+}
+
+void ComponentExtractor::extract(const Mat &mask, FrameResult &result) {
+    CV_Assert(mask.type() == CV_8UC1);
+    Size whole;
+    Point offset;  // Masque éventuellement restreint à une zone (ROI) : coordonnées dans l'image complète
+    mask.locateROI(whole, offset);
+    runs_.clear();
+    parent_.clear();
+
+    // Passe unique : segments de chaque ligne, reliés aux segments voisins de la ligne précédente
+    size_t prev_begin = 0, prev_end = 0;
+    for (int y = 0; y < mask.rows; y++) {
+        const uchar *row = mask.ptr<uchar>(y);
+        size_t cur_begin = runs_.size();
+        size_t p = prev_begin;
+
+        int x = next_set(row, 0, mask.cols);
+        while (x < mask.cols) {
+            int x1 = x + 1;
+            while (x1 < mask.cols && row[x1]) {
+                x1++;
+            }
+
+            Run run = {x, x1, y, (int)parent_.size()};
+            parent_.push_back(run.label);
+
+            // 8-connexité : les segments [a, b[ et [x, x1[ se touchent si a <= x1 et x <= b
+            while (p < prev_end && runs_[p].x1 < x) {
+                p++;
+            }
+            for (size_t q = p; q < prev_end && runs_[q].x0 <= x1; q++) {
+                int a = find_root(runs_[q].label);
+                int b = find_root(run.label);
+                if (a != b) {
+                    parent_[a > b ? a : b] = a < b ? a : b;  // La plus ancienne étiquette reste la racine
+                }
+            }
+            runs_.push_back(run);
+            x = next_set(row, x1, mask.cols);
+        }
+        prev_begin = cur_begin;
+        prev_end = runs_.size();
+    }
+
+    // Cumul des statistiques des segments sur leur composante
+    components_.resize(parent_.size());
+    for (size_t i = 0; i < parent_.size(); i++) {
+        components_[i].area = 0;
+    }
+    for (size_t i = 0; i < runs_.size(); i++) {
+        const Run &run = runs_[i];
+        Component &c = components_[find_root(run.label)];
+        int64_t len = run.x1 - run.x0;
+        if (c.area == 0) {
+            c.sum_x = c.sum_y = 0;
+            c.min_x = run.x0;
+            c.max_x = run.x1 - 1;
+            c.min_y = c.max_y = run.y;
+        }
+        c.area += len;
+        c.sum_x += (int64_t)(run.x0 + run.x1 - 1) * len / 2;
+        c.sum_y += (int64_t)run.y * len;
+        c.min_x = std::min(c.min_x, run.x0);
+        c.max_x = std::max(c.max_x, run.x1 - 1);
+        c.max_y = run.y;  // Segments parcourus ligne par ligne
+    }
+
+    for (size_t i = 0; i < components_.size(); i++) {
+        const Component &c = components_[i];
+        if (c.area == 0 || c.area < min_area_) {
+            continue;  // Étiquette fusionnée dans une autre, ou zone trop petite
+        }
+        if (drop_thin_ && method_ == CENTROID_MOMENTS && c.area == std::max(c.max_x - c.min_x, c.max_y - c.min_y) + 1) {
+            // Un pixel d'épaisseur (pixel isolé, trait droit, diagonal ou en escalier) : contour
+            // d'aire nulle, ignoré comme par ContourExtractor (m00 nul)
+            continue;
+        }
+        MotionRegion region;
+        region.box = Rect(offset.x + c.min_x, offset.y + c.min_y, c.max_x - c.min_x + 1, c.max_y - c.min_y + 1);
+        region.area = (double)c.area;
+        region.contour = -1;
+        if (method_ == CENTROID_MOMENTS) {
+            region.center = Point(offset.x + (int)(c.sum_x / c.area), offset.y + (int)(c.sum_y / c.area));
+        } else {
+            region.center = (region.box.br() + region.box.tl()) * 0.5;
+        }
+        result.regions.push_back(region);
+    }
+}
+
+bool ConsoleSink::on_frame(const char *video_path, Mat &frame, const FrameResult &result) {
+    (void)frame;
+    if (print_pixels_ && result.movement_pixels > 0) {
+        printf("Mouvement détecté dans %s, Nombre de pixels affectés : %d\n", video_path, result.movement_pixels);
+    }
+    if (print_positions_) {
+        for (size_t i = 0; i < result.regions.size(); i++) {
+            printf("Mouvement détecté dans %s à la position : (%d, %d)\n", video_path, result.regions[i].center.x, result.regions[i].center.y);
+        }
+    }
+    return true;
+}
+
+MotionConfig parse_motion_config(int argc, char **argv) {
+    MotionConfig config;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--threshold") == 0) {
+            config.threshold = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--min-area") == 0) {
+            config.min_area = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--coarse") == 0) {
+            config.coarse_scale = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--sample") == 0) {
+            config.sample_every = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--burst") == 0) {
+            config.burst_frames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--backend") == 0) {
+            i++;
+            if (strcmp(argv[i], "mv") == 0) {
+                config.backend = BACKEND_MOTION_VECTORS;
+            } else if (strcmp(argv[i], "pixels") != 0) {
+                fprintf(stderr, "Backend inconnu %s (pixels ou mv), pixels utilisé\n", argv[i]);
+            }
+        } else if (strcmp(argv[i], "--mv-threshold") == 0) {
+            config.mv_threshold = atof(argv[++i]);
+        }
+    }
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--full") == 0) {
+            config.full_analysis = true;  // Option sans valeur : peut être la dernière
+        }
+    }
+    if (config.threshold < 0 || config.threshold > 255) {
+        fprintf(stderr, "Seuil invalide %d, valeur par défaut utilisée\n", config.threshold);
+        config.threshold = MotionConfig().threshold;
+    }
+    return config;
+}
+
+bool parse_resolution(const char *text, int &width, int &height) {
+    static const struct {
+        const char *name;
+        int width, height;
+    } named[] = {
+        {"480p", 854, 480}, {"720p", 1280, 720}, {"1080p", 1920, 1080}, {"1440p", 2560, 1440}, {"4k", 3840, 2160},
+    };
+    for (size_t i = 0; i < sizeof(named) / sizeof(named[0]); i++) {
+        if (strcasecmp(text, named[i].name) == 0) {
+            width = named[i].width;
+            height = named[i].height;
+            return true;
+        }
+    }
+    int w, h;
+    if (sscanf(text, "%dx%d", &w, &h) == 2 && w > 0 && h > 0) {
+        width = w;
+        height = h;
+        return true;
+    }
+    return false;
+}
+
+OutputOptions parse_output_options(int argc, char **argv) {
+    OutputOptions options;
+    parse_io_options(argc, argv);
+    if (!getenv("DISPLAY") && !getenv("WAYLAND_DISPLAY")) {
+        options.display = false;  // Pas de serveur graphique (serveur distant, conteneur...)
+    }
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--headless") == 0) {
+            options.display = false;
+        } else if (strcmp(argv[i], "--annotate") == 0 && i + 1 < argc) {
+            options.annotate_dir = argv[++i];
+        } else if (strcmp(argv[i], "--alloc-stats") == 0) {
+            alloc_counter_enable();
+        } else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+            result_cache_enable(argv[++i]);
+        }
+    }
+    return options;
+}
+
+bool AnnotationSink::on_frame(const char *video_path, Mat &frame, const FrameResult &result) {
+    if (!enabled()) {
+        return true;
+    }
+    draw_motion(frame, result);
+
+    if (options_.annotate_dir) {
+        if (!writer_.isOpened()) {
+            // Ouvrir la vidéo annotée à la première image, quand la taille est connue
+            const char *name = strrchr(video_path, '/');
+            char out_path[512];
+            snprintf(out_path, sizeof(out_path), "%s/%s.annotated.avi", options_.annotate_dir, name ? name + 1 : video_path);
+            if (!writer_.open(out_path, VideoWriter::fourcc('M', 'J', 'P', 'G'), 25.0, frame.size())) {
+                fprintf(stderr, "Erreur lors de l'ouverture de la vidéo annotée %s\n", out_path);
+                options_.annotate_dir = nullptr;
+            }
+        }
+        if (writer_.isOpened()) {
+            writer_.write(frame);
+        }
+    }
+
+    if (options_.display) {
+        imshow(window_name_, frame);
+        return waitKey(30) < 0;  // Arrêter si une touche est pressée
+    }
+    return true;
+}
+
+void AnnotationSink::end_video(const char *video_path, bool movement_detected) {
+    (void)video_path;
+    (void)movement_detected;
+    writer_.release();
+}
+
+void SinkChain::begin_video(const char *video_path) {
+    for (size_t i = 0; i < sinks_.size(); i++) {
+        sinks_[i]->begin_video(video_path);
+    }
+}
+
+bool SinkChain::wants_frame() const {
+    for (size_t i = 0; i < sinks_.size(); i++) {
+        if (sinks_[i]->wants_frame()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SinkChain::on_frame(const char *video_path, Mat &frame, const FrameResult &result) {
+    for (size_t i = 0; i < sinks_.size(); i++) {
+        if (!sinks_[i]->on_frame(video_path, frame, result)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void SinkChain::end_video(const char *video_path, bool movement_detected) {
+    for (size_t i = 0; i < sinks_.size(); i++) {
+        sinks_[i]->end_video(video_path, movement_detected);
+    }
+}
+
+MotionDetector::MotionDetector(const MotionConfig &config)
+    : config_(config), contour_extractor_(config.centroid, config.min_area),
+      component_extractor_(config.centroid, config.min_area),
+      default_extractor_(config.regions == REGIONS_CONTOURS ? (RegionExtractor *)&contour_extractor_
+                                                            : &component_extractor_),
+      extractor_(default_extractor_),
+      cur_gray_(0), cur_coarse_(0),
+      mv_extractor_(config.centroid, (config.min_area + MV_CELL * MV_CELL - 1) / (MV_CELL * MV_CELL), false),
+      first_frame_(true), frame_index_(0) {}
+
+void MotionDetector::set_extractor(RegionExtractor *extractor) {
+    extractor_ = extractor ? extractor : default_extractor_;
+}
+
+void MotionDetector::reset() {
+    prev_luma_.release();
+    first_frame_ = true;
+    frame_index_ = 0;
+}
+
+bool MotionDetector::use_coarse(const Mat &image) const {
+    const int scale = config_.coarse_scale;
+    return scale > 1 && image.cols >= scale && image.rows >= scale;
+}
+
+void MotionDetector::downscale(const Mat &image, Mat &coarse) {
+    const int scale = config_.coarse_scale;
+    resize(image, coarse, Size(image.cols / scale, image.rows / scale), 0, 0, INTER_AREA);
+}
+
+int MotionDetector::coarse_to_fine(const Mat &cur, const Mat &prev, Rect &changed) {
+    const int scale = config_.coarse_scale;
+    const int tiles_x = (cur.cols + COARSE_TILE - 1) / COARSE_TILE;
+    const int tiles_y = (cur.rows + COARSE_TILE - 1) / COARSE_TILE;
+
+    if (diff_.size() != cur.size() || diff_.type() != CV_8UC1) {
+        diff_.create(cur.size(), CV_8UC1);
+        diff_.setTo(Scalar(0));  // Hors des tuiles changées, le masque reste à zéro
+        dirty_tiles_.clear();
+    }
+    dirty_tiles_.resize(tiles_x * tiles_y, 0);
+    tiles_.assign(tiles_x * tiles_y, 0);
+
+    // Niveau réduit : tuiles touchées par un pixel en mouvement (et leurs voisines,
+    // la moyenne pouvant atténuer le bord d'une zone)
+    int coarse_pixels = fused_motion_luma(coarse_[cur_coarse_], coarse_[cur_coarse_ ^ 1], coarse_mask_, config_.threshold);
+    for (int cy = 0; coarse_pixels > 0 && cy < coarse_mask_.rows; cy++) {
+        const uchar *row = coarse_mask_.ptr<uchar>(cy);
+        const int ty = cy * scale / COARSE_TILE;
+        int cx = next_set(row, 0, coarse_mask_.cols);
+        while (cx < coarse_mask_.cols) {
+            const int tx = cx * scale / COARSE_TILE;
+            for (int y = std::max(ty - 1, 0); y <= std::min(ty + 1, tiles_y - 1); y++) {
+                for (int x = std::max(tx - 1, 0); x <= std::min(tx + 1, tiles_x - 1); x++) {
+                    tiles_[y * tiles_x + x] = 1;
+                }
+            }
+            // Reprendre à la tuile suivante
+            cx = next_set(row, ((tx + 1) * COARSE_TILE + scale - 1) / scale, coarse_mask_.cols);
+        }
+    }
+
+    // Effacer les tuiles écrites à l'image précédente qui ne sont pas recalculées
+    for (int i = 0; i < tiles_x * tiles_y; i++) {
+        if (dirty_tiles_[i] && !tiles_[i]) {
+            Rect tile((i % tiles_x) * COARSE_TILE, (i / tiles_x) * COARSE_TILE, COARSE_TILE, COARSE_TILE);
+            diff_(tile & Rect(0, 0, cur.cols, cur.rows)).setTo(Scalar(0));
+        }
+    }
+
+    // Pleine résolution, seulement sur les suites de tuiles changées de chaque rangée
+    int count = 0;
+    changed = Rect();
+    for (int ty = 0; ty < tiles_y; ty++) {
+        for (int tx = 0; tx < tiles_x; tx++) {
+            if (!tiles_[ty * tiles_x + tx]) {
+                continue;
+            }
+            int end = tx;
+            while (end < tiles_x && tiles_[ty * tiles_x + end]) {
+                end++;
+            }
+            Rect span = Rect(tx * COARSE_TILE, ty * COARSE_TILE, (end - tx) * COARSE_TILE, COARSE_TILE) &
+                        Rect(0, 0, cur.cols, cur.rows);
+            Mat mask = diff_(span);
+            count += fused_motion_luma(cur(span), prev(span), mask, config_.threshold);
+            changed = changed.empty() ? span : (changed | span);
+            tx = end;
+        }
+    }
+    dirty_tiles_.swap(tiles_);
+    return count;
+}
+
+void MotionDetector::detect(const Mat &cur, const Mat &prev, bool coarse, FrameResult &result) {
+    Rect changed(0, 0, cur.cols, cur.rows);
+    if (coarse) {
+        result.movement_pixels = coarse_to_fine(cur, prev, changed);
+    } else {
+        // Différence, seuil et comptage en une passe
+        result.movement_pixels = fused_motion_luma(cur, prev, diff_, config_.threshold);
+    }
+
+    // Trouver les zones de mouvement (inutile si aucun pixel n'a changé), dans les tuiles changées seulement
+    if (config_.find_regions && result.movement_pixels > 0) {
+        extractor_->extract(diff_(changed), result);
+    }
+}
+
+bool MotionDetector::process(const Mat &frame, FrameResult &result) {
+    result.frame_index = frame_index_++;
+    result.regions.clear();
+    result.contours = nullptr;
+
+    Mat &gray = gray_[cur_gray_];
+    const Mat &prev_gray = gray_[cur_gray_ ^ 1];
+    const bool coarse = use_coarse(frame);
+
+    if (coarse) {
+        // Gris seul (prev_gray vide), puis détection sur la pyramide
+        fused_motion(frame, Mat(), gray, diff_, config_.threshold);
+        downscale(gray, coarse_[cur_coarse_]);
+        result.movement_pixels = 0;
+        if (!first_frame_) {
+            detect(gray, prev_gray, true, result);
+        }
+        cur_coarse_ ^= 1;
+    } else {
+        // Gris, différence, seuil et comptage en une seule passe sur l'image BGR
+        result.movement_pixels = fused_motion(frame, first_frame_ ? Mat() : prev_gray, gray, diff_, config_.threshold);
+        if (!first_frame_ && config_.find_regions && result.movement_pixels > 0) {
+            extractor_->extract(diff_, result);
+        }
+    }
+
+    cur_gray_ ^= 1;  // L'image courante devient la précédente, sans copie
+    first_frame_ = false;
+    return result.movement_pixels > 0;
+}
+
+bool MotionDetector::process_luma(const Mat &luma, FrameResult &result) {
+    result.frame_index = frame_index_++;
+    result.movement_pixels = 0;
+    result.regions.clear();
+    result.contours = nullptr;
+
+    const bool coarse = use_coarse(luma);
+    if (coarse) {
+        downscale(luma, coarse_[cur_coarse_]);
+    }
+    if (!first_frame_) {
+        detect(luma, prev_luma_, coarse, result);  // Directement sur le plan Y
+    }
+    if (coarse) {
+        cur_coarse_ ^= 1;
+    }
+
+    prev_luma_ = luma;  // Simple en-tête : la source conserve l'image précédente
+    first_frame_ = false;
+    return result.movement_pixels > 0;
+}
+
+bool MotionDetector::process_pair(const Mat &luma, const Mat &prev_luma, FrameResult &result) {
+    result.movement_pixels = 0;
+    result.regions.clear();
+    result.contours = nullptr;
+
+    if (!prev_luma.empty()) {
+        const bool coarse = use_coarse(luma);
+        if (coarse) {
+            cur_coarse_ = 0;
+            downscale(luma, coarse_[0]);
+            downscale(prev_luma, coarse_[1]);
+        }
+        detect(luma, prev_luma, coarse, result);
+    }
+    return result.movement_pixels > 0;
+}
+
+bool MotionDetector::process_vectors(const Mat &luma, const std::vector<BlockMotion> &blocks, bool intra,
+                                     FrameResult &result) {
+    result.frame_index = frame_index_++;
+    result.movement_pixels = 0;
+    result.regions.clear();
+    result.contours = nullptr;
+
+    if (intra) {
+        // Pas de vecteurs : différence de luminance avec l'image précédente (aucune à la première)
+        process_pair(luma, first_frame_ ? Mat() : prev_luma_, result);
+    } else {
+        // Cellules couvertes par un bloc qui s'est déplacé d'au moins mv_threshold pixels
+        const int cells_x = (luma.cols + MV_CELL - 1) / MV_CELL;
+        const int cells_y = (luma.rows + MV_CELL - 1) / MV_CELL;
+        mv_mask_.create(cells_y, cells_x, CV_8UC1);
+        mv_mask_.setTo(Scalar(0));
+        const float min_length2 = (float)(config_.mv_threshold * config_.mv_threshold);
+        for (size_t i = 0; i < blocks.size(); i++) {
+            const BlockMotion &block = blocks[i];
+            if (block.dx * block.dx + block.dy * block.dy < min_length2) {
+                continue;
+            }
+            const int x0 = std::max(block.x / MV_CELL, 0);
+            const int y0 = std::max(block.y / MV_CELL, 0);
+            const int x1 = std::min((block.x + block.w + MV_CELL - 1) / MV_CELL, cells_x);
+            const int y1 = std::min((block.y + block.h + MV_CELL - 1) / MV_CELL, cells_y);
+            for (int y = y0; y < y1; y++) {
+                memset(mv_mask_.ptr<uchar>(y) + x0, 255, std::max(x1 - x0, 0));
+            }
+        }
+        result.movement_pixels = countNonZero(mv_mask_) * MV_CELL * MV_CELL;
+
+        if (config_.find_regions && result.movement_pixels > 0) {
+            // Zones trouvées sur la grille des cellules, ramenées en pixels (rectangles, sans contours)
+            mv_extractor_.extract(mv_mask_, result);
+            for (size_t i = 0; i < result.regions.size(); i++) {
+                MotionRegion &region = result.regions[i];
+                region.center = Point(region.center.x * MV_CELL + MV_CELL / 2, region.center.y * MV_CELL + MV_CELL / 2);
+                region.box = Rect(region.box.x * MV_CELL, region.box.y * MV_CELL, region.box.width * MV_CELL,
+                                  region.box.height * MV_CELL);
+                region.area *= MV_CELL * MV_CELL;
+                region.contour = -1;
+            }
+        }
+    }
+
+    prev_luma_ = luma;  // Simple en-tête : la source conserve l'image précédente
+    first_frame_ = false;
+    return result.movement_pixels > 0;
+}
+
+void draw_motion(Mat &frame, const FrameResult &result) {
+    for (size_t i = 0; i < result.regions.size(); i++) {
+        const MotionRegion &region = result.regions[i];
+
+        // Dessiner le contour (ou le rectangle englobant) en vert et le centre en rouge
+        if (result.contours && region.contour >= 0) {
+            drawContours(frame, *result.contours, region.contour, Scalar(0, 255, 0), 2);
+        } else {
+            rectangle(frame, region.box, Scalar(0, 255, 0), 2);
+        }
+        circle(frame, region.center, 5, Scalar(0, 0, 255), -1);
+
+        // Afficher la position du centre sur l'image (texte bleu)
+        char text[50];
+        snprintf(text, sizeof(text), "Pos: (%d, %d)", region.center.x, region.center.y);
+        putText(frame, text, Point(region.center.x + 10, region.center.y + 10), FONT_HERSHEY_SIMPLEX, 0.7, Scalar(255, 0, 0), 2);
+    }
+}
+
+int run_video(const char *video_path, MotionDetector &detector, MotionSink *sink) {
+    // Résultat déjà connu pour ce contenu et ces paramètres : pas de décodage. Le verrou
+    // fait attendre la fin de l'analyse d'une copie identique en cours dans un autre worker.
+    ResultCache *cache = result_cache();
+    CacheKey key;
+    int lock_fd = -1;
+    if (cache && cache->key(video_path, detector.config(), key)) {
+        lock_fd = cache->lock(key);
+        CachedResult cached;
+        if (cache->lookup(key, cached)) {
+            cache->unlock(lock_fd);
+            print_cached_result(video_path, cached);
+            if (sink) {
+                sink->begin_video(video_path);
+                sink->end_video(video_path, cached.motion);
+            }
+            return cached.motion ? 1 : 0;
+        }
+    } else {
+        cache = nullptr;
+    }
+
+    const double video_start = wall_time();
+    VideoReader reader;
+    const bool use_vectors = detector.config().backend == BACKEND_MOTION_VECTORS;
+    reader.set_export_motion_vectors(use_vectors);
+    if (!reader.open(video_path)) {
+        fprintf(stderr, "Erreur lors de l'ouverture de la vidéo %s\n", video_path);
+        if (cache) {
+            cache->unlock(lock_fd);
+        }
+        return -1;
+    }
+
+    detector.reset();
+    if (sink) {
+        sink->begin_video(video_path);
+    }
+
+    Mat luma, frame;
+    FrameResult result;
+    std::vector<BlockMotion> blocks;  // Vecteurs de l'image courante (BACKEND_MOTION_VECTORS)
+    bool movement_detected = false;
+    CachedResult summary;      // Résumé de la vidéo, mémorisé dans le cache
+    bool interrupted = false;  // Arrêt demandé par la sortie : résumé incomplet
+    const bool want_frame = sink && sink->wants_frame();
+    int frames = 0;
+    uint64_t steady_allocations = 0;  // Allocations du thread au début de la deuxième image
+
+    // Échantillonnage adaptatif : une image sur sample_every tant que rien ne bouge,
+    // toutes les images pendant burst_frames images après un mouvement
+    const int sample_every = detector.config().sample_every > 1 ? detector.config().sample_every : 1;
+    int burst = 0;  // Images restant à analyser une par une
+    bool skipping = false;
+
+    for (;;) {
+        const bool quiet = sample_every > 1 && burst == 0;
+        if (quiet != skipping) {
+            reader.set_skip_nonref(quiet);  // Au calme, les images B ne sont même pas décodées
+            skipping = quiet;
+        }
+        if (quiet && frames > 0) {
+            int skipped = 0;
+            while (skipped < sample_every - 1 && reader.grab()) {
+                skipped++;  // Décodée (référence du décodeur) mais ni exposée ni analysée
+            }
+            if (skipped < sample_every - 1) {
+                break;
+            }
+        }
+        if (!reader.read_luma(luma)) {
+            break;
+        }
+        if (++frames == 2) {
+            steady_allocations = thread_allocations();
+        }
+
+        bool moved;
+        if (use_vectors) {
+            // Images intra, ou sans vecteurs exportés : repli sur la différence de pixels
+            bool has_vectors = reader.motion_vectors(blocks);
+            moved = detector.process_vectors(luma, blocks, reader.frame_is_intra() || !has_vectors, result);
+        } else {
+            moved = detector.process_luma(luma, result);
+        }
+        movement_detected = movement_detected || moved;
+        if (sample_every > 1) {
+            result.frame_index = (int)reader.frame_number();  // Numéro réel, images sautées comprises
+            burst = moved ? detector.config().burst_frames : (burst > 0 ? burst - 1 : 0);
+        }
+        summary.frames++;
+        if (moved) {
+            summary.motion_frames++;
+            if (summary.first_motion < 0) {
+                summary.first_motion = result.frame_index;
+            }
+        }
+
+        if (sink) {
+            if (want_frame) {
+                reader.retrieve_bgr(frame);  // BGR seulement pour les images annotées ou affichées
+            }
+            if (!sink->on_frame(video_path, frame, result)) {
+                interrupted = true;
+                break;
+            }
+        }
+        if (moved && detector.config().stop_at_first) {
+            break;  // Sortir dès qu'un mouvement est détecté
+        }
+    }
+
+    if (alloc_counter_enabled() && frames >= 2) {
+        uint64_t count = thread_allocations() - steady_allocations;
+        printf("%s : %.2f allocation(s) par image après la première (%llu sur %d images)\n", video_path,
+               (double)count / (frames - 1), (unsigned long long)count, frames - 1);
+    }
+
+    if (io_stats_enabled() && reader.io_stats()) {
+        print_io_stats(video_path, *reader.io_stats(), wall_time() - video_start);
+    }
+
+    reader.close();
+    if (cache) {
+        if (!interrupted) {
+            summary.motion = movement_detected;
+            cache->store(key, summary);
+        }
+        cache->unlock(lock_fd);
+    }
+    if (sink) {
+        sink->end_video(video_path, movement_detected);
+    }
+    return movement_detected ? 1 : 0;
+}
+
+double wall_time() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
@@ -0,0 +1,285 @@
+#ifndef MOTION_ENGINE_HPP
+#define MOTION_ENGINE_HPP
+
+// Moteur commun de détection de mouvement.
+//
+// Toutes les variantes (monothread, multiprocessus, multithreads, ...) partagent
+// ce moteur : elles ne s'occupent que de l'ordonnancement des vidéos, le travail
+// par image est identique partout. Le traitement se fait image par image
+// (MotionDetector::process) et se compose d'étapes interchangeables :
+//   - extraction des zones de mouvement à partir du masque (RegionExtractor)
+//   - exploitation des résultats : affichage, journal, pipe... (MotionSink)
+
+#include <opencv2/opencv.hpp>
+#include <stdint.h>
+#include <vector>
+
+#define MV_CELL 8  // Côté des cellules du masque des vecteurs de mouvement (pixels)
+
+// Méthode de calcul du centre d'une zone de mouvement
+enum CentroidMethod {
+    CENTROID_MOMENTS,      // Centre de masse du contour (moments), zones d'aire nulle ignorées
+    CENTROID_BOUNDING_BOX  // Centre du rectangle englobant
+};
+
+// Méthode d'extraction des zones de mouvement
+enum RegionMethod {
+    REGIONS_COMPONENTS,  // Composantes connexes (8-connexité) en une passe sur le masque
+    REGIONS_CONTOURS     // findContours (RETR_EXTERNAL), contours disponibles pour le dessin
+};
+
+// Source des mouvements dans run_video
+enum DetectorBackend {
+    BACKEND_PIXELS,         // Différence de luminance entre images successives
+    BACKEND_MOTION_VECTORS  // Vecteurs de mouvement du codec, pixels seulement sur les images intra
+};
+
+struct BlockMotion;
+
+// Paramètres du détecteur
+struct MotionConfig {
+    int threshold = 25;                        // Seuil appliqué à la différence absolue
+    CentroidMethod centroid = CENTROID_MOMENTS;
+    RegionMethod regions = REGIONS_COMPONENTS;
+    int min_area = 0;                          // Zones plus petites ignorées (pixels)
+    int coarse_scale = 1;                      // > 1 : détection d'abord sur l'image réduite de ce facteur,
+                                               // puis pleine résolution dans les tuiles changées seulement
+    int sample_every = 1;                      // > 1 : une image analysée sur sample_every tant que rien ne bouge
+    int burst_frames = 50;                     // Images toutes analysées après un mouvement (avec sample_every > 1)
+    DetectorBackend backend = BACKEND_PIXELS;
+    double mv_threshold = 1.0;                 // Déplacement minimal d'un bloc en mouvement (pixels, vecteurs)
+    bool find_regions = true;                  // false : seulement compter les pixels en mouvement
+    bool stop_at_first = false;                // Arrêter la vidéo au premier mouvement détecté
+    bool full_analysis = false;                // --full : les variantes qui s'arrêtent au premier mouvement,
+                                               // ne cherchent pas les zones ou sondent (--query) analysent
+                                               // quand même toutes les images avec extraction des zones
+};
+
+// Zone de mouvement détectée dans une image
+struct MotionRegion {
+    cv::Point center;  // Centre de la zone
+    cv::Rect box;      // Rectangle englobant
+    double area;       // Aire de la zone (pixels)
+    int contour;       // Indice du contour associé, -1 si aucun
+};
+
+// Résultat du traitement d'une image
+struct FrameResult {
+    int frame_index = 0;
+    int movement_pixels = 0;  // Nombre de pixels au-dessus du seuil
+    std::vector<MotionRegion> regions;
+    const std::vector<std::vector<cv::Point>> *contours = nullptr;  // Contours des zones (peut être NULL)
+};
+
+// Étape d'extraction des zones de mouvement à partir du masque binaire
+class RegionExtractor {
+public:
+    virtual ~RegionExtractor() {}
+    // mask peut être une zone (ROI) du masque complet : les positions sont données dans l'image complète
+    virtual void extract(const cv::Mat &mask, FrameResult &result) = 0;
+};
+
+// Extraction par findContours (RETR_EXTERNAL) puis centre par moments ou rectangle englobant
+class ContourExtractor : public RegionExtractor {
+public:
+    explicit ContourExtractor(CentroidMethod method = CENTROID_MOMENTS, int min_area = 0)
+        : method_(method), min_area_(min_area) {}
+    void extract(const cv::Mat &mask, FrameResult &result) override;
+
+private:
+    CentroidMethod method_;
+    int min_area_;
+    std::vector<std::vector<cv::Point>> contours_;
+};
+
+// Extraction par étiquetage des composantes connexes en une seule passe sur le masque :
+// les segments de pixels de chaque ligne sont reliés à ceux de la ligne précédente
+// (union-find), l'aire, le rectangle englobant et le centre de masse sont cumulés au
+// passage. Pas de contours (result.contours reste NULL) ; tampons réutilisés d'une image à l'autre.
+// Avec CENTROID_MOMENTS sur un masque de pixels, les composantes d'un pixel d'épaisseur (autant
+// de pixels que leur plus grande dimension) sont ignorées, comme les contours d'aire nulle de
+// ContourExtractor. drop_thin faux garde ces composantes (grille des cellules du backend mv,
+// où une cellule seule est un vrai bloc en mouvement).
+class ComponentExtractor : public RegionExtractor {
+public:
+    explicit ComponentExtractor(CentroidMethod method = CENTROID_MOMENTS, int min_area = 0, bool drop_thin = true)
+        : method_(method), min_area_(min_area), drop_thin_(drop_thin) {}
+    void extract(const cv::Mat &mask, FrameResult &result) override;
+
+private:
+    struct Run {
+        int x0, x1;  // Segment [x0, x1[ de la ligne y
+        int y;
+        int label;
+    };
+    struct Component {
+        int64_t area, sum_x, sum_y;
+        int min_x, min_y, max_x, max_y;
+    };
+
+    int find_root(int label);
+
+    CentroidMethod method_;
+    int min_area_;
+    bool drop_thin_;
+    std::vector<Run> runs_;
+    std::vector<int> parent_;
+    std::vector<Component> components_;
+};
+
+// Étape de sortie : reçoit chaque image et son résultat
+class MotionSink {
+public:
+    virtual ~MotionSink() {}
+    virtual void begin_video(const char *video_path) { (void)video_path; }
+    // true si la sortie utilise l'image BGR ; sinon elle reçoit une image vide et
+    // la conversion BGR n'est pas faite
+    virtual bool wants_frame() const { return false; }
+    // Retourne false pour arrêter le traitement de la vidéo
+    virtual bool on_frame(const char *video_path, cv::Mat &frame, const FrameResult &result) = 0;
+    virtual void end_video(const char *video_path, bool movement_detected) { (void)video_path; (void)movement_detected; }
+};
+
+// Sortie console : nombre de pixels en mouvement et/ou position de chaque zone
+class ConsoleSink : public MotionSink {
+public:
+    ConsoleSink(bool print_pixels, bool print_positions)
+        : print_pixels_(print_pixels), print_positions_(print_positions) {}
+    bool on_frame(const char *video_path, cv::Mat &frame, const FrameResult &result) override;
+
+private:
+    bool print_pixels_;
+    bool print_positions_;
+};
+
+// Sorties visuelles facultatives, choisies en ligne de commande
+struct OutputOptions {
+    bool display = true;                  // Fenêtre imshow + waitKey(30)
+    const char *annotate_dir = nullptr;   // Dossier des vidéos annotées (NULL : pas d'écriture)
+};
+
+// Lit --threshold <seuil>, --min-area <pixels>, --coarse <facteur>, --sample <n>, --burst <images>,
+// --backend pixels|mv, --mv-threshold <pixels> et --full ; les autres paramètres gardent leur valeur
+// par défaut
+MotionConfig parse_motion_config(int argc, char **argv);
+
+// Lit une résolution "480p", "720p", "1080p", "1440p", "4k" ou "<largeur>x<hauteur>"
+// (vidéos de test, images brutes d'un flux)
+bool parse_resolution(const char *text, int &width, int &height);
+
+// Lit --headless, --annotate <dossier>, --alloc-stats (allocations par image, cf. alloc_counter.hpp),
+// --cache <dossier> (résultats par vidéo, cf. result_cache.hpp) et les options d'entrée --io,
+// --io-readahead, --io-stats (cf. video_io.hpp) ; sans serveur graphique, l'affichage est désactivé
+OutputOptions parse_output_options(int argc, char **argv);
+
+// Sortie qui dessine les zones sur l'image puis l'affiche et/ou l'écrit dans une vidéo annotée.
+// En mode headless sans --annotate, elle ne fait rien : ni dessin, ni imshow, ni waitKey.
+class AnnotationSink : public MotionSink {
+public:
+    explicit AnnotationSink(const OutputOptions &options, const char *window_name = "Mouvement Détecté")
+        : options_(options), window_name_(window_name) {}
+    bool enabled() const { return options_.display || options_.annotate_dir; }
+    bool wants_frame() const override { return enabled(); }
+    bool on_frame(const char *video_path, cv::Mat &frame, const FrameResult &result) override;
+    void end_video(const char *video_path, bool movement_detected) override;
+
+private:
+    OutputOptions options_;
+    const char *window_name_;
+    cv::VideoWriter writer_;
+};
+
+// Sortie composée : transmet à plusieurs sorties dans l'ordre
+class SinkChain : public MotionSink {
+public:
+    void add(MotionSink *sink) { sinks_.push_back(sink); }
+    void begin_video(const char *video_path) override;
+    bool wants_frame() const override;
+    bool on_frame(const char *video_path, cv::Mat &frame, const FrameResult &result) override;
+    void end_video(const char *video_path, bool movement_detected) override;
+
+private:
+    std::vector<MotionSink *> sinks_;
+};
+
+// Détecteur de mouvement par différence entre images successives
+class MotionDetector {
+public:
+    explicit MotionDetector(const MotionConfig &config = MotionConfig());
+
+    // Remplace l'étape d'extraction (non possédée, NULL pour revenir à celle par défaut)
+    void set_extractor(RegionExtractor *extractor);
+    const MotionConfig &config() const { return config_; }
+
+    // Réinitialise l'état entre deux vidéos
+    void reset();
+
+    // Traite une image BGR (CV_8UC3) ; retourne true si des pixels en mouvement ont été trouvés
+    bool process(const cv::Mat &frame, FrameResult &result);
+
+    // Traite directement un plan de luminance (CV_8UC1) sans le copier.
+    // La source doit garder l'image précédente valide jusqu'à l'appel suivant (cf. VideoReader).
+    bool process_luma(const cv::Mat &luma, FrameResult &result);
+
+    // Traite une image à partir des vecteurs de mouvement de ses blocs (BACKEND_MOTION_VECTORS) :
+    // cellules de MV_CELL pixels couvertes par un bloc déplacé d'au moins config.mv_threshold,
+    // sans différence de pixels. intra (pas de vecteurs) : repli sur la différence de luminance
+    // avec l'image précédente. luma suit les mêmes règles de validité que pour process_luma.
+    bool process_vectors(const cv::Mat &luma, const std::vector<BlockMotion> &blocks, bool intra,
+                         FrameResult &result);
+
+    // Traite une paire (image, image précédente) sans utiliser l'état du détecteur :
+    // pour les threads d'analyse qui reçoivent les images dans le désordre.
+    // prev_luma vide : première image, aucun mouvement. result.frame_index n'est pas modifié.
+    bool process_pair(const cv::Mat &luma, const cv::Mat &prev_luma, FrameResult &result);
+
+    // Masque binaire de la dernière image traitée
+    const cv::Mat &mask() const { return diff_; }
+
+private:
+    bool use_coarse(const cv::Mat &image) const;
+    void downscale(const cv::Mat &image, cv::Mat &coarse);
+    int coarse_to_fine(const cv::Mat &cur, const cv::Mat &prev, cv::Rect &changed);
+    void detect(const cv::Mat &cur, const cv::Mat &prev, bool coarse, FrameResult &result);
+
+    MotionConfig config_;
+    ContourExtractor contour_extractor_;
+    ComponentExtractor component_extractor_;
+    RegionExtractor *default_extractor_;  // Choisi par config.regions
+    RegionExtractor *extractor_;
+    cv::Mat gray_[2];    // Gris courant et précédent, échangés à chaque image (pas de copie)
+    int cur_gray_;
+    cv::Mat diff_;
+    cv::Mat coarse_[2];   // Images réduites courante et précédente (mode pyramide)
+    int cur_coarse_;
+    cv::Mat coarse_mask_;
+    std::vector<unsigned char> tiles_, dirty_tiles_;  // Tuiles recalculées à cette image / écrites à la précédente
+    cv::Mat prev_luma_;  // En-tête sur l'image précédente de la source (pas de copie)
+    cv::Mat mv_mask_;    // Cellules en mouvement d'après les vecteurs (une par MV_CELL x MV_CELL pixels)
+    ComponentExtractor mv_extractor_;  // Zones sur la grille des cellules (min_area en cellules)
+    bool first_frame_;
+    int frame_index_;
+};
+
+// Dessine les contours, centres et positions d'un résultat sur l'image
+void draw_motion(cv::Mat &frame, const FrameResult &result);
+
+// Traite une vidéo complète avec le détecteur ; sink peut être NULL.
+// La vidéo est décodée directement en luminance ; le BGR n'est produit que si sink->wants_frame().
+// Avec config.sample_every > 1, les images sautées sont décodées sans être analysées ni transmises
+// à sink (les images B ne sont pas décodées du tout) ; result.frame_index garde le numéro réel.
+// Après la première image, la boucle ne fait plus d'allocation : tampons du lecteur, du
+// détecteur et des résultats réutilisés (hors sorties visuelles et contours OpenCV).
+// Avec config.backend == BACKEND_MOTION_VECTORS, les vecteurs exportés par le décodeur remplacent
+// la différence de pixels (sauf sur les images intra).
+// Avec le cache activé (--cache), une vidéo déjà analysée avec les mêmes paramètres, ou une copie
+// identique, n'est pas décodée : son résumé est affiché et sink ne reçoit que begin/end_video.
+// Retourne -1 si la vidéo ne peut pas être ouverte, 1 si un mouvement a été détecté, 0 sinon.
+int run_video(const char *video_path, MotionDetector &detector, MotionSink *sink);
+
+// Temps mural en secondes (CLOCK_MONOTONIC), pour les temps d'exécution affichés.
+// clock() ne compte que le temps CPU du processus appelant : ni l'attente des threads
+// ou des enfants, ni le temps CPU des processus enfants.
+double wall_time();
+
+#endif // MOTION_ENGINE_HPP
@@ -0,0 +1,271 @@
+#include "motion_kernels.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MOTION_KERNELS_X86 1
+#endif
+
+using namespace cv;
+
+// Coefficients de cvtColor(COLOR_BGR2GRAY) en virgule fixe sur 14 bits
+enum { GRAY_SHIFT = 14, GRAY_B = 1868, GRAY_G = 9617, GRAY_R = 4899 };
+
+typedef int (*fused_row_fn)(const unsigned char *, const unsigned char *, unsigned char *, unsigned char *, int, int);
+
+static inline unsigned char gray_pixel(const unsigned char *p) {
+    return (unsigned char)((p[0] * GRAY_B + p[1] * GRAY_G + p[2] * GRAY_R + (1 << (GRAY_SHIFT - 1))) >> GRAY_SHIFT);
+}
+
+static int fused_row_scalar(const unsigned char *bgr, const unsigned char *prev_gray,
+                            unsigned char *gray, unsigned char *mask, int width, int threshold) {
+    int count = 0;
+    for (int x = 0; x < width; x++) {
+        unsigned char g = gray_pixel(bgr + 3 * x);
+        gray[x] = g;
+        if (prev_gray) {
+            int d = g > prev_gray[x] ? g - prev_gray[x] : prev_gray[x] - g;
+            unsigned char m = d > threshold ? 255 : 0;
+            mask[x] = m;
+            count += m & 1;
+        }
+    }
+    return count;
+}
+
+static int diff_row_scalar(const unsigned char *gray, const unsigned char *prev_gray,
+                           unsigned char *mask, int width, int threshold) {
+    int count = 0;
+    for (int x = 0; x < width; x++) {
+        int d = gray[x] > prev_gray[x] ? gray[x] - prev_gray[x] : prev_gray[x] - gray[x];
+        unsigned char m = d > threshold ? 255 : 0;
+        mask[x] = m;
+        count += m & 1;
+    }
+    return count;
+}
+
+#ifdef MOTION_KERNELS_X86
+
+// Masque |cur - prev| > seuil sur 16 pixels : diff - seuil (saturé) != 0
+__attribute__((target("sse4.1")))
+static inline __m128i motion_mask16(__m128i cur, __m128i prev, __m128i thr) {
+    __m128i diff = _mm_or_si128(_mm_subs_epu8(cur, prev), _mm_subs_epu8(prev, cur));
+    return _mm_xor_si128(_mm_cmpeq_epi8(_mm_subs_epu8(diff, thr), _mm_setzero_si128()), _mm_set1_epi8(-1));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i motion_mask32(__m256i cur, __m256i prev, __m256i thr) {
+    __m256i diff = _mm256_or_si256(_mm256_subs_epu8(cur, prev), _mm256_subs_epu8(prev, cur));
+    return _mm256_xor_si256(_mm256_cmpeq_epi8(_mm256_subs_epu8(diff, thr), _mm256_setzero_si256()), _mm256_set1_epi8(-1));
+}
+
+// Sépare 16 pixels BGR entrelacés (48 octets) en trois registres B, G, R
+__attribute__((target("sse4.1")))
+static inline void deinterleave_bgr16(const unsigned char *p, __m128i &b, __m128i &g, __m128i &r) {
+    const __m128i a0 = _mm_loadu_si128((const __m128i *)p);
+    const __m128i a1 = _mm_loadu_si128((const __m128i *)(p + 16));
+    const __m128i a2 = _mm_loadu_si128((const __m128i *)(p + 32));
+
+    b = _mm_or_si128(_mm_or_si128(
+            _mm_shuffle_epi8(a0, _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+            _mm_shuffle_epi8(a1, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1))),
+            _mm_shuffle_epi8(a2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13)));
+    g = _mm_or_si128(_mm_or_si128(
+            _mm_shuffle_epi8(a0, _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+            _mm_shuffle_epi8(a1, _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1))),
+            _mm_shuffle_epi8(a2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14)));
+    r = _mm_or_si128(_mm_or_si128(
+            _mm_shuffle_epi8(a0, _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+            _mm_shuffle_epi8(a1, _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1))),
+            _mm_shuffle_epi8(a2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15)));
+}
+
+// 8 pixels 16 bits -> 8 niveaux de gris 32 bits répartis en deux registres (b*B + g*G, r*R + arrondi)
+__attribute__((target("sse4.1")))
+static inline __m128i gray8_sse(__m128i b16, __m128i g16, __m128i r16) {
+    const __m128i kbg = _mm_set1_epi32((GRAY_G << 16) | GRAY_B);
+    const __m128i kr = _mm_set1_epi32(((1 << (GRAY_SHIFT - 1)) << 16) | GRAY_R);
+    const __m128i one = _mm_set1_epi16(1);
+
+    __m128i lo = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(b16, g16), kbg),
+                               _mm_madd_epi16(_mm_unpacklo_epi16(r16, one), kr));
+    __m128i hi = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(b16, g16), kbg),
+                               _mm_madd_epi16(_mm_unpackhi_epi16(r16, one), kr));
+    return _mm_packs_epi32(_mm_srai_epi32(lo, GRAY_SHIFT), _mm_srai_epi32(hi, GRAY_SHIFT));
+}
+
+__attribute__((target("sse4.1")))
+static int fused_row_sse41(const unsigned char *bgr, const unsigned char *prev_gray,
+                           unsigned char *gray, unsigned char *mask, int width, int threshold) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i thr = _mm_set1_epi8((char)threshold);
+    int count = 0;
+    int x = 0;
+
+    for (; x + 16 <= width; x += 16) {
+        __m128i b, g, r;
+        deinterleave_bgr16(bgr + 3 * x, b, g, r);
+
+        __m128i lo = gray8_sse(_mm_unpacklo_epi8(b, zero), _mm_unpacklo_epi8(g, zero), _mm_unpacklo_epi8(r, zero));
+        __m128i hi = gray8_sse(_mm_unpackhi_epi8(b, zero), _mm_unpackhi_epi8(g, zero), _mm_unpackhi_epi8(r, zero));
+        __m128i cur = _mm_packus_epi16(lo, hi);
+        _mm_storeu_si128((__m128i *)(gray + x), cur);
+
+        if (prev_gray) {
+            __m128i m = motion_mask16(cur, _mm_loadu_si128((const __m128i *)(prev_gray + x)), thr);
+            _mm_storeu_si128((__m128i *)(mask + x), m);
+            count += __builtin_popcount(_mm_movemask_epi8(m));
+        }
+    }
+
+    return count + fused_row_scalar(bgr + 3 * x, prev_gray ? prev_gray + x : NULL, gray + x, mask + x, width - x, threshold);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i gray16_avx2(__m256i b16, __m256i g16, __m256i r16) {
+    const __m256i kbg = _mm256_set1_epi32((GRAY_G << 16) | GRAY_B);
+    const __m256i kr = _mm256_set1_epi32(((1 << (GRAY_SHIFT - 1)) << 16) | GRAY_R);
+    const __m256i one = _mm256_set1_epi16(1);
+
+    __m256i lo = _mm256_add_epi32(_mm256_madd_epi16(_mm256_unpacklo_epi16(b16, g16), kbg),
+                                  _mm256_madd_epi16(_mm256_unpacklo_epi16(r16, one), kr));
+    __m256i hi = _mm256_add_epi32(_mm256_madd_epi16(_mm256_unpackhi_epi16(b16, g16), kbg),
+                                  _mm256_madd_epi16(_mm256_unpackhi_epi16(r16, one), kr));
+    return _mm256_packs_epi32(_mm256_srai_epi32(lo, GRAY_SHIFT), _mm256_srai_epi32(hi, GRAY_SHIFT));
+}
+
+// Les unpack/pack AVX2 travaillent par demi-registre de 128 bits : l'ordre des
+// pixels est conservé puisque chaque dépaquetage est suivi du paquetage inverse.
+__attribute__((target("avx2")))
+static int fused_row_avx2(const unsigned char *bgr, const unsigned char *prev_gray,
+                          unsigned char *gray, unsigned char *mask, int width, int threshold) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i thr = _mm256_set1_epi8((char)threshold);
+    int count = 0;
+    int x = 0;
+
+    for (; x + 32 <= width; x += 32) {
+        __m128i b0, g0, r0, b1, g1, r1;
+        deinterleave_bgr16(bgr + 3 * x, b0, g0, r0);
+        deinterleave_bgr16(bgr + 3 * x + 48, b1, g1, r1);
+        __m256i b = _mm256_inserti128_si256(_mm256_castsi128_si256(b0), b1, 1);
+        __m256i g = _mm256_inserti128_si256(_mm256_castsi128_si256(g0), g1, 1);
+        __m256i r = _mm256_inserti128_si256(_mm256_castsi128_si256(r0), r1, 1);
+
+        __m256i lo = gray16_avx2(_mm256_unpacklo_epi8(b, zero), _mm256_unpacklo_epi8(g, zero), _mm256_unpacklo_epi8(r, zero));
+        __m256i hi = gray16_avx2(_mm256_unpackhi_epi8(b, zero), _mm256_unpackhi_epi8(g, zero), _mm256_unpackhi_epi8(r, zero));
+        __m256i cur = _mm256_packus_epi16(lo, hi);
+        _mm256_storeu_si256((__m256i *)(gray + x), cur);
+
+        if (prev_gray) {
+            __m256i m = motion_mask32(cur, _mm256_loadu_si256((const __m256i *)(prev_gray + x)), thr);
+            _mm256_storeu_si256((__m256i *)(mask + x), m);
+            count += __builtin_popcount((unsigned)_mm256_movemask_epi8(m));
+        }
+    }
+
+    return count + fused_row_sse41(bgr + 3 * x, prev_gray ? prev_gray + x : NULL, gray + x, mask + x, width - x, threshold);
+}
+
+__attribute__((target("sse4.1")))
+static int diff_row_sse41(const unsigned char *gray, const unsigned char *prev_gray,
+                          unsigned char *mask, int width, int threshold) {
+    const __m128i thr = _mm_set1_epi8((char)threshold);
+    int count = 0;
+    int x = 0;
+
+    for (; x + 16 <= width; x += 16) {
+        __m128i m = motion_mask16(_mm_loadu_si128((const __m128i *)(gray + x)),
+                                  _mm_loadu_si128((const __m128i *)(prev_gray + x)), thr);
+        _mm_storeu_si128((__m128i *)(mask + x), m);
+        count += __builtin_popcount(_mm_movemask_epi8(m));
+    }
+
+    return count + diff_row_scalar(gray + x, prev_gray + x, mask + x, width - x, threshold);
+}
+
+__attribute__((target("avx2")))
+static int diff_row_avx2(const unsigned char *gray, const unsigned char *prev_gray,
+                         unsigned char *mask, int width, int threshold) {
+    const __m256i thr = _mm256_set1_epi8((char)threshold);
+    int count = 0;
+    int x = 0;
+
+    for (; x + 32 <= width; x += 32) {
+        __m256i m = motion_mask32(_mm256_loadu_si256((const __m256i *)(gray + x)),
+                                  _mm256_loadu_si256((const __m256i *)(prev_gray + x)), thr);
+        _mm256_storeu_si256((__m256i *)(mask + x), m);
+        count += __builtin_popcount((unsigned)_mm256_movemask_epi8(m));
+    }
+
+    return count + diff_row_sse41(gray + x, prev_gray + x, mask + x, width - x, threshold);
+}
+
+#endif // MOTION_KERNELS_X86
+
+typedef int (*diff_row_fn)(const unsigned char *, const unsigned char *, unsigned char *, int, int);
+
+struct FusedKernel {
+    fused_row_fn fn;
+    diff_row_fn diff;
+    const char *isa;
+};
+
+// Choix de la variante selon le processeur, une seule fois
+static FusedKernel select_fused_kernel() {
+#ifdef MOTION_KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return FusedKernel{fused_row_avx2, diff_row_avx2, "avx2"};
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        return FusedKernel{fused_row_sse41, diff_row_sse41, "sse4.1"};
+    }
+#endif
+    return FusedKernel{fused_row_scalar, diff_row_scalar, "scalar"};
+}
+
+static const FusedKernel &fused_kernel() {
+    static const FusedKernel kernel = select_fused_kernel();
+    return kernel;
+}
+
+int fused_motion_row(const unsigned char *bgr, const unsigned char *prev_gray,
+                     unsigned char *gray, unsigned char *mask, int width, int threshold) {
+    return fused_kernel().fn(bgr, prev_gray, gray, mask, width, threshold);
+}
+
+int fused_motion(const Mat &bgr, const Mat &prev_gray, Mat &gray, Mat &mask, int threshold) {
+    CV_Assert(bgr.type() == CV_8UC3 && threshold >= 0 && threshold <= 255);
+    const bool has_prev = !prev_gray.empty();
+    if (has_prev) {
+        CV_Assert(prev_gray.type() == CV_8UC1 && prev_gray.size() == bgr.size());
+        mask.create(bgr.size(), CV_8UC1);
+    }
+    gray.create(bgr.size(), CV_8UC1);
+
+    fused_row_fn fn = fused_kernel().fn;
+    int count = 0;
+    for (int y = 0; y < bgr.rows; y++) {
+        count += fn(bgr.ptr<unsigned char>(y), has_prev ? prev_gray.ptr<unsigned char>(y) : NULL,
+                    gray.ptr<unsigned char>(y), has_prev ? mask.ptr<unsigned char>(y) : NULL, bgr.cols, threshold);
+    }
+    return count;
+}
+
+int fused_motion_luma(const Mat &gray, const Mat &prev_gray, Mat &mask, int threshold) {
+    CV_Assert(gray.type() == CV_8UC1 && prev_gray.type() == CV_8UC1 && gray.size() == prev_gray.size());
+    CV_Assert(threshold >= 0 && threshold <= 255);
+    mask.create(gray.size(), CV_8UC1);
+
+    diff_row_fn fn = fused_kernel().diff;
+    int count = 0;
+    for (int y = 0; y < gray.rows; y++) {
+        count += fn(gray.ptr<unsigned char>(y), prev_gray.ptr<unsigned char>(y), mask.ptr<unsigned char>(y), gray.cols, threshold);
+    }
+    return count;
+}
+
+const char *fused_motion_isa() {
+    return fused_kernel().isa;
+}
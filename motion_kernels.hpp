@@ -0,0 +1,32 @@
+#ifndef MOTION_KERNELS_HPP
+#define MOTION_KERNELS_HPP
+
+// Noyaux optimisés du détecteur de mouvement.
+//
+// Le chemin cvtColor -> absdiff -> threshold -> countNonZero fait quatre passes
+// sur l'image avec une Mat intermédiaire à chaque étape. Le noyau fusionné lit
+// l'image BGR une seule fois et produit dans la même passe l'image en niveaux de
+// gris (pour l'image suivante), le masque binaire et le nombre de pixels en
+// mouvement. La version AVX2, SSE4.1 ou scalaire est choisie à l'exécution.
+
+#include <opencv2/opencv.hpp>
+
+// Traite une ligne de width pixels.
+// prev_gray peut être NULL (première image) : seule la ligne en gris est produite.
+// mask reçoit 255 si |gray - prev_gray| > threshold, 0 sinon (comme THRESH_BINARY).
+// Retourne le nombre de pixels à 255 dans mask.
+int fused_motion_row(const unsigned char *bgr, const unsigned char *prev_gray,
+                     unsigned char *gray, unsigned char *mask, int width, int threshold);
+
+// Applique le noyau à une image BGR (CV_8UC3) complète.
+// prev_gray vide : seule gray est produite (mask n'est pas modifié) et le résultat vaut 0.
+int fused_motion(const cv::Mat &bgr, const cv::Mat &prev_gray, cv::Mat &gray, cv::Mat &mask, int threshold);
+
+// Variante pour une entrée déjà en niveaux de gris (plan Y du décodeur) :
+// différence, seuil et comptage en une passe. gray et prev_gray peuvent avoir un pas quelconque.
+int fused_motion_luma(const cv::Mat &gray, const cv::Mat &prev_gray, cv::Mat &mask, int threshold);
+
+// Nom de la variante choisie à l'exécution ("avx2", "sse4.1" ou "scalar")
+const char *fused_motion_isa();
+
+#endif // MOTION_KERNELS_HPP
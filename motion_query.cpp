@@ -0,0 +1,157 @@
+#include "motion_query.hpp"
+#include "video_reader.hpp"
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+QueryMode parse_query_mode(int argc, char **argv) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--query") == 0) {
+            if (strcmp(argv[i + 1], "any") == 0) {
+                return QUERY_ANY;
+            }
+            if (strcmp(argv[i + 1], "first") == 0) {
+                return QUERY_FIRST;
+            }
+            fprintf(stderr, "Mode de requête inconnu %s (any ou first), requête désactivée\n", argv[i + 1]);
+        }
+    }
+    return QUERY_OFF;
+}
+
+// État d'une requête : lecteur, détecteur et compteurs partagés par les sondages
+struct QueryState {
+    VideoReader reader;
+    MotionDetector detector;
+    Mat luma;
+    FrameResult result;
+    MotionQuery *query;
+
+    explicit QueryState(const MotionConfig &config) : detector(config), query(nullptr) {}
+
+    // Décode l'image suivante et la compare à la précédente ; false en fin de fichier
+    bool step(bool &moved) {
+        if (!reader.read_luma(luma)) {
+            return false;
+        }
+        query->decoded_frames++;
+        moved = detector.process_luma(luma, result);
+        return true;
+    }
+
+    void found() {
+        query->motion = true;
+        query->frame = reader.frame_number();
+        double fps = reader.fps();
+        query->time = fps > 0 ? query->frame / fps : reader.pts() * reader.time_base();
+    }
+
+    // Sonde l'image clé pts : seek puis QUERY_PROBE_FRAMES images ; true si mouvement
+    bool probe(int64_t pts) {
+        query->probes++;
+        if (!reader.seek(pts)) {
+            return false;
+        }
+        detector.reset();  // Pas de différence avec l'image d'avant le seek
+        for (int i = 0; i < QUERY_PROBE_FRAMES; i++) {
+            bool moved;
+            if (!step(moved)) {
+                return false;
+            }
+            if (moved) {
+                found();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Décode depuis l'image courante jusqu'au premier mouvement (ou la fin du fichier)
+    bool scan() {
+        bool moved;
+        while (step(moved)) {
+            if (moved) {
+                found();
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+bool query_motion(const char *video_path, const MotionConfig &config, QueryMode mode, MotionQuery &query) {
+    query = MotionQuery();
+
+    // Seulement compter les pixels en mouvement : la réponse ne dépend pas des zones
+    MotionConfig probe_config = config;
+    probe_config.find_regions = false;
+    QueryState state(probe_config);
+    state.query = &query;
+    if (!state.reader.open(video_path)) {
+        fprintf(stderr, "Erreur lors de l'ouverture de la vidéo %s\n", video_path);
+        return false;
+    }
+    query.total_frames = state.reader.frame_count();
+
+    vector<int64_t> keys = state.reader.keyframes();
+    if (keys.size() < 2) {
+        // Une seule image clé : rien à sonder, décodage séquentiel
+        state.scan();
+        return true;
+    }
+
+    // 1. Images clés réparties sur tout le fichier
+    vector<bool> probed(keys.size(), false);
+    int spread = keys.size() < QUERY_SPREAD_PROBES ? (int)keys.size() : QUERY_SPREAD_PROBES;
+    int hit = -1;
+    for (int i = 0; i < spread && hit < 0; i++) {
+        size_t k = keys.size() * i / spread;
+        probed[k] = true;
+        if (state.probe(keys[k])) {
+            hit = (int)k;
+        }
+    }
+    if (hit >= 0 && mode == QUERY_ANY) {
+        return true;
+    }
+
+    // 2. Autres images clés dans l'ordre (seulement avant le sondage positif en mode premier
+    //    mouvement) : la première qui bouge est la première image clé en mouvement
+    int limit = hit >= 0 ? hit : (int)keys.size();
+    for (int k = 0; k < limit; k++) {
+        if (!probed[k]) {
+            probed[k] = true;
+            if (state.probe(keys[k])) {
+                hit = k;
+                break;
+            }
+        }
+    }
+    if (hit < 0 || mode == QUERY_ANY) {
+        return true;
+    }
+
+    // 3. Le mouvement a pu commencer dans le groupe d'images précédent, après son sondage :
+    //    le décoder en entier (jusqu'au sondage positif au plus)
+    if (hit > 0 && state.reader.seek(keys[hit - 1])) {
+        state.detector.reset();
+        state.scan();
+    }
+    return true;
+}
+
+void print_motion_query(const char *video_path, const MotionQuery &query) {
+    double part = query.total_frames > 0 ? 100.0 * query.decoded_frames / query.total_frames : 0.0;
+    if (query.motion) {
+        printf("%s : mouvement à %.2f s (image %lld) ; %lld image(s) décodée(s) sur %lld (%.1f %%), %d sondage(s)\n",
+               video_path, query.time, (long long)query.frame, (long long)query.decoded_frames,
+               (long long)query.total_frames, part, query.probes);
+    } else {
+        printf("%s : aucun mouvement ; %lld image(s) décodée(s) sur %lld (%.1f %%), %d sondage(s)\n", video_path,
+               (long long)query.decoded_frames, (long long)query.total_frames, part, query.probes);
+    }
+}
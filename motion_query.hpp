@@ -0,0 +1,46 @@
+#ifndef MOTION_QUERY_HPP
+#define MOTION_QUERY_HPP
+
+// Requête rapide « cette vidéo contient-elle du mouvement ? ».
+//
+// Au lieu de décoder depuis la première image jusqu'au premier mouvement, on
+// sonde d'abord quelques images clés réparties sur tout le fichier (seek, puis
+// QUERY_PROBE_FRAMES images décodées et comparées), puis toutes les autres images
+// clés dans l'ordre. En mode premier mouvement, les images clés qui précèdent le
+// premier sondage positif sont toutes sondées, puis le groupe d'images qui le
+// précède est décodé en entier pour trouver la première image en mouvement.
+// Seules quelques images par groupe sont décodées : un mouvement plus court qu'un
+// groupe d'images et tombé entre deux sondages peut être manqué.
+
+#include "motion_engine.hpp"
+
+#include <stdint.h>
+
+#define QUERY_PROBE_FRAMES 3    // Images décodées à chaque image clé sondée (deux différences)
+#define QUERY_SPREAD_PROBES 16  // Images clés sondées en premier, réparties sur le fichier
+
+enum QueryMode {
+    QUERY_OFF,    // Traitement complet habituel
+    QUERY_ANY,    // Oui/non : arrêt au premier sondage positif
+    QUERY_FIRST   // Oui/non et première image en mouvement
+};
+
+struct MotionQuery {
+    bool motion = false;
+    int64_t frame = -1;          // Image en mouvement trouvée (la première en QUERY_FIRST), -1 sinon
+    double time = -1.0;          // Horodatage de cette image en secondes, -1 sinon
+    int64_t decoded_frames = 0;  // Images décodées pour répondre
+    int64_t total_frames = 0;    // Images du fichier (d'après le conteneur)
+    int probes = 0;              // Images clés sondées
+};
+
+// Lit --query any|first (QUERY_OFF sans l'option)
+QueryMode parse_query_mode(int argc, char **argv);
+
+// Répond à la requête pour une vidéo ; retourne false si elle ne peut pas être ouverte
+bool query_motion(const char *video_path, const MotionConfig &config, QueryMode mode, MotionQuery &query);
+
+// Affiche la réponse : mouvement oui/non, horodatage et part des images décodées
+void print_motion_query(const char *video_path, const MotionQuery &query);
+
+#endif // MOTION_QUERY_HPP
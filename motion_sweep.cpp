@@ -0,0 +1,231 @@
+#include "motion_sweep.hpp"
+#include "motion_kernels.hpp"
+#include "video_reader.hpp"
+
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+using namespace cv;
+using namespace std;
+
+MotionSweep::MotionSweep(const vector<MotionConfig> &configs)
+    : prev_frame_(-1), video_path_("") {
+    for (size_t i = 0; i < configs.size(); i++) {
+        variants_.push_back(new Variant(configs[i]));
+    }
+}
+
+MotionSweep::~MotionSweep() {
+    for (size_t i = 0; i < variants_.size(); i++) {
+        if (variants_[i]->out) {
+            fclose(variants_[i]->out);
+        }
+        delete variants_[i];
+    }
+}
+
+bool MotionSweep::open_outputs(const char *dir) {
+    for (size_t i = 0; i < variants_.size(); i++) {
+        char path[512];
+        snprintf(path, sizeof(path), "%s/config_%zu.csv", dir, i);
+        variants_[i]->out = fopen(path, "w");
+        if (!variants_[i]->out) {
+            fprintf(stderr, "Impossible de créer le fichier de résultats %s\n", path);
+            return false;
+        }
+        const MotionConfig &c = variants_[i]->config;
+        fprintf(variants_[i]->out, "# threshold=%d min_area=%d sample=%d regions=%s centroid=%s\n", c.threshold,
+                c.min_area, c.sample_every, c.regions == REGIONS_CONTOURS ? "contours" : "components",
+                c.centroid == CENTROID_MOMENTS ? "moments" : "bbox");
+        fprintf(variants_[i]->out, "video,frame,pixels,regions\n");
+    }
+    return true;
+}
+
+void MotionSweep::begin_video(const char *video_path) {
+    video_path_ = video_path;
+    for (size_t i = 0; i < variants_.size(); i++) {
+        Variant &v = *variants_[i];
+        v.burst = 0;
+        v.last_analysed = -1;
+        v.moved = false;
+    }
+    prev_luma_.release();
+    prev_frame_ = -1;
+    for (size_t i = 0; i < masks_.size(); i++) {
+        masks_[i].frame = -1;
+    }
+}
+
+bool MotionSweep::wants_frame(const Variant &v, int64_t frame_index) const {
+    const int sample_every = v.config.sample_every > 1 ? v.config.sample_every : 1;
+    if (v.last_analysed < 0 || sample_every == 1 || v.burst > 0) {
+        return true;
+    }
+    return frame_index - v.last_analysed >= sample_every;  // Au calme : une image sur sample_every
+}
+
+const MotionSweep::SharedMask &MotionSweep::shared_mask(int level, const Mat &luma, int64_t frame_index) {
+    size_t i = 0;
+    while (i < masks_.size() && masks_[i].threshold != level) {
+        i++;
+    }
+    if (i == masks_.size()) {
+        masks_.push_back(SharedMask{level, Mat(), 0, -1});
+    }
+    SharedMask &shared = masks_[i];
+    if (shared.frame != frame_index) {
+        // Même noyau que MotionDetector : résultats identiques à run_video, au pixel près
+        shared.count = fused_motion_luma(luma, prev_luma_, shared.mask, level);
+        shared.frame = frame_index;
+    }
+    return shared;
+}
+
+void MotionSweep::process_luma(const Mat &luma, int64_t frame_index) {
+    for (size_t i = 0; i < variants_.size(); i++) {
+        Variant &v = *variants_[i];
+        if (!wants_frame(v, frame_index)) {
+            continue;
+        }
+
+        FrameResult &result = v.result;
+        result.frame_index = (int)frame_index;
+        result.movement_pixels = 0;
+        result.regions.clear();
+        result.contours = nullptr;
+
+        const Mat *mask = nullptr;
+        if (v.last_analysed >= 0 && v.last_analysed == prev_frame_ && prev_frame_ == frame_index - 1) {
+            // Référence = image précédente : masque commun aux configurations de même seuil
+            const SharedMask &shared = shared_mask(v.config.threshold, luma, frame_index);
+            result.movement_pixels = shared.count;
+            mask = &shared.mask;
+        } else if (v.last_analysed >= 0) {
+            // Référence plus ancienne (échantillonnage) : différence propre à la configuration
+            result.movement_pixels = fused_motion_luma(luma, v.last, v.mask, v.config.threshold);
+            mask = &v.mask;
+        }
+        if (mask && v.config.find_regions && result.movement_pixels > 0) {
+            v.extractor->extract(*mask, result);
+        }
+
+        const bool moved = result.movement_pixels > 0;
+        v.stats.frames_analysed++;
+        if (moved) {
+            v.stats.frames_with_motion++;
+            v.stats.regions += result.regions.size();
+            v.stats.movement_pixels += result.movement_pixels;
+            if (!v.moved) {
+                v.stats.videos_with_motion++;
+                v.moved = true;
+            }
+            if (v.out) {
+                fprintf(v.out, "%s,%lld,%d,%zu\n", video_path_, (long long)frame_index, result.movement_pixels,
+                        result.regions.size());
+            }
+        }
+
+        if (v.config.sample_every > 1) {
+            v.burst = moved ? v.config.burst_frames : (v.burst > 0 ? v.burst - 1 : 0);
+            luma.copyTo(v.last);  // La prochaine image analysée peut ne pas être la suivante
+        }
+        v.last_analysed = frame_index;
+    }
+
+    prev_luma_ = luma;  // Simple en-tête : la source conserve l'image précédente
+    prev_frame_ = frame_index;
+}
+
+// Liste d'entiers séparés par des virgules
+static vector<int> parse_int_list(const char *text) {
+    vector<int> values;
+    string list = text;
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t end = list.find(',', start);
+        if (end == string::npos) {
+            end = list.size();
+        }
+        if (end > start) {
+            values.push_back(atoi(list.substr(start, end - start).c_str()));
+        }
+        start = end + 1;
+    }
+    return values;
+}
+
+vector<MotionConfig> parse_sweep_configs(int argc, char **argv, const MotionConfig &base) {
+    vector<int> thresholds(1, base.threshold), min_areas(1, base.min_area), samples(1, base.sample_every);
+    vector<RegionMethod> regions(1, base.regions);
+    vector<CentroidMethod> centroids(1, base.centroid);
+
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--sweep-threshold") == 0) {
+            thresholds = parse_int_list(argv[++i]);
+        } else if (strcmp(argv[i], "--sweep-min-area") == 0) {
+            min_areas = parse_int_list(argv[++i]);
+        } else if (strcmp(argv[i], "--sweep-sample") == 0) {
+            samples = parse_int_list(argv[++i]);
+        } else if (strcmp(argv[i], "--sweep-regions") == 0) {
+            const char *list = argv[++i];
+            regions.clear();
+            if (strstr(list, "components")) {
+                regions.push_back(REGIONS_COMPONENTS);
+            }
+            if (strstr(list, "contours")) {
+                regions.push_back(REGIONS_CONTOURS);
+            }
+        } else if (strcmp(argv[i], "--sweep-centroid") == 0) {
+            const char *list = argv[++i];
+            centroids.clear();
+            if (strstr(list, "moments")) {
+                centroids.push_back(CENTROID_MOMENTS);
+            }
+            if (strstr(list, "bbox")) {
+                centroids.push_back(CENTROID_BOUNDING_BOX);
+            }
+        }
+    }
+
+    vector<MotionConfig> configs;
+    for (size_t t = 0; t < thresholds.size(); t++) {
+        if (thresholds[t] < 0 || thresholds[t] > 255) {
+            fprintf(stderr, "Seuil invalide %d, ignoré\n", thresholds[t]);
+            continue;
+        }
+        for (size_t a = 0; a < min_areas.size(); a++) {
+            for (size_t s = 0; s < samples.size(); s++) {
+                for (size_t r = 0; r < regions.size(); r++) {
+                    for (size_t c = 0; c < centroids.size(); c++) {
+                        MotionConfig config = base;
+                        config.threshold = thresholds[t];
+                        config.min_area = min_areas[a];
+                        config.sample_every = samples[s];
+                        config.regions = regions[r];
+                        config.centroid = centroids[c];
+                        configs.push_back(config);
+                    }
+                }
+            }
+        }
+    }
+    return configs;
+}
+
+int64_t run_sweep(const char *video_path, MotionSweep &sweep) {
+    VideoReader reader;
+    if (!reader.open(video_path)) {
+        fprintf(stderr, "Erreur lors de l'ouverture de la vidéo %s\n", video_path);
+        return -1;
+    }
+
+    sweep.begin_video(video_path);
+    Mat luma;
+    int64_t frames = 0;
+    while (reader.read_luma(luma)) {
+        sweep.process_luma(luma, frames++);
+    }
+    return frames;
+}
@@ -0,0 +1,105 @@
+#ifndef MOTION_SWEEP_HPP
+#define MOTION_SWEEP_HPP
+
+// Balayage de paramètres en un seul décodage.
+//
+// Régler le seuil, l'aire minimale, l'extraction des zones ou l'échantillonnage
+// demandait un décodage complet des vidéos par réglage. Ici chaque image décodée
+// alimente toutes les configurations : le masque d'un seuil (différence, seuil et
+// comptage fusionnés, le même noyau que run_video) est calculé une fois pour toutes
+// les configurations qui l'utilisent. Chaque configuration garde ses propres
+// statistiques (et éventuellement son fichier de résultats par image).
+//
+// Les configurations échantillonnées (sample_every > 1) ne choisissent pas les mêmes
+// images que run_video : ici toutes les images sont décodées et comptées, une sur
+// sample_every est comparée à la dernière image analysée (copie propre), alors que
+// run_video ne décode pas les images B au calme (set_skip_nonref) et numérote les
+// images d'après le décodeur. Sur un flux avec images B, leurs résultats ne sont donc
+// pas directement comparables à ceux d'un --sample n ; sans échantillonnage, ils sont
+// identiques. Le mode pyramide (coarse_scale) et le backend par vecteurs sont ignorés.
+
+#include "motion_engine.hpp"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+// Résultats d'une configuration, cumulés sur les vidéos traitées
+struct SweepStats {
+    int64_t frames_analysed = 0;
+    int64_t frames_with_motion = 0;
+    int videos_with_motion = 0;
+    int64_t regions = 0;
+    int64_t movement_pixels = 0;
+};
+
+class MotionSweep {
+public:
+    explicit MotionSweep(const std::vector<MotionConfig> &configs);
+    ~MotionSweep();
+    MotionSweep(const MotionSweep &) = delete;
+    MotionSweep &operator=(const MotionSweep &) = delete;
+
+    // Écrit une ligne « vidéo,image,pixels,zones » par image en mouvement et par configuration
+    // dans <dir>/config_<i>.csv ; false si un fichier ne peut pas être créé
+    bool open_outputs(const char *dir);
+
+    // Début d'une vidéo : remet à zéro l'état des images (pas les statistiques cumulées)
+    void begin_video(const char *video_path);
+
+    // Image suivante de la vidéo (plan Y) ; l'image précédente doit rester valide (cf. VideoReader)
+    void process_luma(const cv::Mat &luma, int64_t frame_index);
+
+    size_t size() const { return variants_.size(); }
+    const MotionConfig &config(size_t i) const { return variants_[i]->config; }
+    const SweepStats &stats(size_t i) const { return variants_[i]->stats; }
+
+private:
+    struct Variant {
+        MotionConfig config;
+        ContourExtractor contours;
+        ComponentExtractor components;
+        RegionExtractor *extractor;
+        int burst;                 // Images restant à analyser une par une après un mouvement
+        int64_t last_analysed;     // Dernière image analysée (-1 : aucune)
+        bool moved;                // Mouvement dans la vidéo en cours
+        cv::Mat last;              // Copie de la dernière image analysée (configurations échantillonnées)
+        cv::Mat mask;              // Masque propre quand l'image de référence n'est pas la précédente
+        FrameResult result;
+        SweepStats stats;
+        FILE *out;
+
+        explicit Variant(const MotionConfig &c)
+            : config(c), contours(c.centroid, c.min_area), components(c.centroid, c.min_area),
+              extractor(c.regions == REGIONS_CONTOURS ? (RegionExtractor *)&contours : &components), burst(0),
+              last_analysed(-1), moved(false), out(nullptr) {}
+    };
+
+    // Masque du seuil level (image / image précédente), calculé au plus une fois par image
+    struct SharedMask {
+        int threshold;
+        cv::Mat mask;
+        int count;
+        int64_t frame;
+    };
+
+    bool wants_frame(const Variant &v, int64_t frame_index) const;
+    const SharedMask &shared_mask(int level, const cv::Mat &luma, int64_t frame_index);
+
+    std::vector<Variant *> variants_;
+    std::vector<SharedMask> masks_;
+    cv::Mat prev_luma_;  // Image décodée précédente (en-tête, pas de copie)
+    int64_t prev_frame_;
+    const char *video_path_;
+};
+
+// Lit --sweep-threshold, --sweep-min-area, --sweep-sample, --sweep-regions components,contours
+// et --sweep-centroid moments,bbox (listes séparées par des virgules) : une configuration par
+// combinaison, les paramètres absents gardent la valeur de base
+std::vector<MotionConfig> parse_sweep_configs(int argc, char **argv, const MotionConfig &base);
+
+// Décode une vidéo une fois et la passe à toutes les configurations ; retourne le nombre
+// d'images décodées, -1 si la vidéo ne peut pas être ouverte
+int64_t run_sweep(const char *video_path, MotionSweep &sweep);
+
+#endif // MOTION_SWEEP_HPP
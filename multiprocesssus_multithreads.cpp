@@ -7,57 +7,134 @@
 #include <time.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include <sys/mman.h>
 #include <sys/wait.h>  // Ajout de l'en-tête nécessaire pour wait()
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include "motion_engine.hpp"
+#include "result_cache.hpp"
+#include "thread_budget.hpp"
+#include "thread_pool.hpp"
+#include "video_io.hpp"
+#include "video_reader.hpp"
 
 using namespace cv;
 
+// Paramètres du détecteur choisis en ligne de commande (cf. parse_motion_config)
+static MotionConfig motion_config;
+
+// Répartition des cœurs entre processus, threads, OpenCV et décodeur (cf. thread_budget.hpp)
+static ThreadBudget budget;
+
+#define THREADS_PER_PROCESS 4  // Threads par processus sans --processes
+#define MAX_WORKERS 256
+
+// Vidéo à traiter et son coût estimé avant le fork (images x pixels par image)
+struct VideoJob {
+    char *path;
+    int64_t frames;
+    int width, height;
+    int64_t cost;
+};
+
+// File commune à tous les processus (mmap partagé créé avant fork) : chaque worker prend
+// la vidéo suivante dans l'ordre des coûts décroissants dès qu'il est libre
+struct SharedQueue {
+    std::atomic<int> next;
+    std::atomic<int64_t> load[MAX_WORKERS];  // Coût traité par chaque worker
+};
+
+static VideoJob *jobs;
+static int job_count;
+static SharedQueue *queue;
+
+// Sortie de cette variante : une ligne par image en mouvement, sans le nombre de pixels
+class MotionLineSink : public MotionSink {
+public:
+    bool on_frame(const char *video_path, Mat &frame, const FrameResult &result) override {
+        (void)frame;
+        if (result.movement_pixels > 0) {
+            printf("Mouvement détecté dans %s\n", video_path);
+        }
+        return true;
+    }
+};
+
 void *detect_movement(void *arg) {
     const char *video_path = (const char *)arg;
     printf("Traitement de la vidéo dans un thread : %s\n", video_path);
-    VideoCapture cap(video_path);
-    if (!cap.isOpened()) {
-        fprintf(stderr, "Erreur lors de l'ouverture de la vidéo %s\n", video_path);
-        pthread_exit(NULL);
-    }
-
-    Mat frame, gray, prev_gray, diff;
-    bool first_frame = true;
-
-    while (cap.read(frame)) {
-        cvtColor(frame, gray, COLOR_BGR2GRAY);
-        if (!first_frame) {
-            absdiff(prev_gray, gray, diff);
-            threshold(diff, diff, 25, 255, THRESH_BINARY);
-            int movement_pixels = countNonZero(diff);
-            if (movement_pixels > 0) {
-                printf("Mouvement détecté dans %s\n", video_path);
-            }
+
+    // Seulement compter les pixels en mouvement, sans extraction des zones (sauf --full) ni affichage
+    MotionConfig config = motion_config;
+    config.find_regions = config.full_analysis;
+    static thread_local MotionDetector detector(config);  // Par worker, réutilisé d'une vidéo à l'autre
+    MotionLineSink printer;
+
+    run_video(video_path, detector, &printer);
+    return NULL;
+}
+
+// Boucle d'un worker : vidéos prises dans la file commune jusqu'à ce qu'elle soit vide
+void *worker_loop(void *arg) {
+    int worker = budget.first_worker + (int)(intptr_t)arg;
+    for (;;) {
+        int i = queue->next.fetch_add(1);
+        if (i >= job_count) {
+            break;
         }
-        gray.copyTo(prev_gray);
-        first_frame = false;
+        detect_movement(jobs[i].path);
+        queue->load[worker].fetch_add(jobs[i].cost);
     }
+    return NULL;
+}
 
-    cap.release();
-    pthread_exit(NULL);
+void process_videos_in_directory(int num_threads) {
+    // Les threads du processus (sa part du budget) prennent chacun leurs vidéos dans la file commune
+    ThreadPool pool(num_threads, pin_pool_worker, &budget);
+    for (int i = 0; i < num_threads; i++) {
+        pool.submit(worker_loop, (void *)(intptr_t)i);
+    }
+    pool.wait();
 }
 
-void process_videos_in_directory(char **video_files, int video_count) {
-    pthread_t threads[video_count];
-    
-    // Créer des threads en parallèle pour traiter les vidéos simultanément dans chaque processus
+// Mesure le nombre d'images et la résolution de chaque vidéo (sans décodage) puis trie
+// les vidéos par coût décroissant : les plus longues partent en premier, les courtes
+// comblent la fin (ordonnancement « plus long d'abord » sur une file dynamique)
+static void plan_jobs(char **video_files, int video_count) {
+    jobs = (VideoJob *)malloc(video_count * sizeof(VideoJob));
+    job_count = video_count;
     for (int i = 0; i < video_count; i++) {
-        pthread_create(&threads[i], NULL, detect_movement, video_files[i]);
+        VideoReader reader;
+        VideoJob &job = jobs[i];
+        job.path = video_files[i];
+        job.frames = 0;
+        job.width = job.height = 0;
+        if (reader.open(video_files[i])) {
+            job.frames = reader.frame_count();
+            job.width = reader.width();
+            job.height = reader.height();
+        }
+        job.cost = job.frames * job.width * job.height;
     }
+    std::stable_sort(jobs, jobs + job_count,
+                     [](const VideoJob &a, const VideoJob &b) { return a.cost > b.cost; });
 
-    // Attendre la fin de tous les threads
-    for (int i = 0; i < video_count; i++) {
-        pthread_join(threads[i], NULL);
-        free(video_files[i]);  // Libérer la mémoire de chaque chemin vidéo
+    printf("Ordre de traitement (plus long d'abord) :\n");
+    for (int i = 0; i < job_count; i++) {
+        printf("  %s : %lld images %dx%d\n", jobs[i].path, (long long)jobs[i].frames, jobs[i].width, jobs[i].height);
     }
 }
 
-int main() {
-    clock_t start_time = clock();
+int main(int argc, char **argv) {
+    double start_time = wall_time();
+    motion_config = parse_motion_config(argc, argv);
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--cache") == 0) {
+            result_cache_enable(argv[i + 1]);  // Pas de sortie visuelle ici : seule option de sortie lue
+        }
+    }
+    parse_io_options(argc, argv);
 
     struct dirent *entry;
     DIR *dir = opendir("videos");
@@ -82,30 +159,60 @@ int main() {
 
     closedir(dir);
 
-    // Déterminer le nombre de processus à créer (en fonction des cœurs disponibles)
-    int num_processes = 4; // Exemple avec 4 processus. Vous pouvez ajuster selon le nombre de cœurs.
-    int videos_per_process = video_count / num_processes;
-    if (video_count % num_processes != 0) {
-        videos_per_process++;
+    if (video_count == 0) {
+        free(video_files);
+        return 0;
     }
 
+    // Workers (threads d'analyse) d'après les cœurs disponibles, quota cgroup compris
+    // (--workers <n>), répartis sur --processes <n> processus (THREADS_PER_PROCESS par défaut).
+    // MAX_WORKERS est appliqué par le plan lui-même : la part de cœurs de chaque worker
+    // (threads décodeur, pool OpenCV) est calculée sur le nombre de workers réellement lancés.
+    budget = parse_thread_budget(argc, argv, video_count < MAX_WORKERS ? video_count : MAX_WORKERS);
+    int num_processes = (budget.workers + THREADS_PER_PROCESS - 1) / THREADS_PER_PROCESS;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--processes") == 0) {
+            num_processes = atoi(argv[++i]);
+        }
+    }
+    if (num_processes < 1) {
+        num_processes = 1;
+    }
+    if (num_processes > budget.workers) {
+        num_processes = budget.workers;
+    }
+    // Pool OpenCV dimensionné pour le processus le plus chargé ; chaque enfant le
+    // recalcule ensuite d'après ses propres threads
+    set_process_workers(budget, (budget.workers + num_processes - 1) / num_processes);
+    apply_thread_budget(budget);  // Hérité par les processus enfants
+    print_thread_budget(budget);
+
+    plan_jobs(video_files, video_count);
+    queue = (SharedQueue *)mmap(NULL, sizeof(SharedQueue), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (queue == MAP_FAILED) {
+        perror("Erreur lors de la création de la mémoire partagée");
+        return 1;
+    }
+    new (queue) SharedQueue();  // Compteur et charges à zéro
+
     // Créer plusieurs processus pour traiter les vidéos
     pid_t pid;
+    int first_worker = 0;
     for (int i = 0; i < num_processes; i++) {
+        // Workers de ce processus : part égale des workers du budget
+        int num_threads = budget.workers / num_processes + (i < budget.workers % num_processes ? 1 : 0);
+        fflush(stdout);
         pid = fork();
         if (pid == 0) {  // Code du processus enfant
-            // Diviser les vidéos à traiter pour ce processus
-            int start_index = i * videos_per_process;
-            int end_index = (i + 1) * videos_per_process;
-            if (end_index > video_count) {
-                end_index = video_count;
-            }
-            
-            // Processus traite les vidéos assignées
-            process_videos_in_directory(&video_files[start_index], end_index - start_index);
+            // Processus traite les vidéos prises dans la file commune
+            budget.first_worker = first_worker;
+            set_process_workers(budget, num_threads);
+            apply_thread_budget(budget);
+            process_videos_in_directory(num_threads);
 
             exit(0); // Quitter le processus enfant après traitement
         }
+        first_worker += num_threads;
     }
 
     // Attendre que tous les processus enfants terminent
@@ -113,10 +220,26 @@ int main() {
         wait(NULL);
     }
 
+    // Équilibre obtenu : charge du worker le plus chargé par rapport à la charge moyenne
+    int64_t total = 0, max_load = 0;
+    for (int i = 0; i < budget.workers; i++) {
+        int64_t load = queue->load[i].load();
+        total += load;
+        max_load = std::max(max_load, load);
+    }
+    if (total > 0) {
+        printf("Charge du worker le plus chargé : %.0f %% de la moyenne (%d workers)\n",
+               100.0 * max_load * budget.workers / total, budget.workers);
+    }
+    munmap(queue, sizeof(SharedQueue));
+    free(jobs);
+
+    for (int i = 0; i < video_count; i++) {
+        free(video_files[i]);  // Libérer la mémoire de chaque chemin vidéo
+    }
     free(video_files);  // Libérer la mémoire du tableau des chemins vidéo
 
-    clock_t end_time = clock();
-    double elapsed_time = ((double)(end_time - start_time)) / CLOCKS_PER_SEC;
+    double elapsed_time = wall_time() - start_time;
     printf("Temps total d'exécution (Multiprocessus + Multithreads) : %.2f secondes\n", elapsed_time);
 
     return 0;
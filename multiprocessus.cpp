@@ -7,65 +7,37 @@
 #include <time.h>
 #include <unistd.h>
 #include <vector>  // Ajoutez cet en-tête pour utiliser std::vector
+#include "motion_engine.hpp"
+#include "process_pool.hpp"
+#include "thread_budget.hpp"
 
 using namespace cv;
 using namespace std;  // N'oubliez pas d'ajouter cet espace de noms pour std::vector
 
-int detect_movement(const char *video_path) {
-    printf("Traitement de la vidéo : %s dans le processus %d\n", video_path, getpid());
-    VideoCapture cap(video_path);
-    if (!cap.isOpened()) {
-        fprintf(stderr, "Erreur lors de l'ouverture de la vidéo %s\n", video_path);
-        return -1;
-    }
-
-    Mat frame, gray, prev_gray, diff;
-    bool first_frame = true;
-
-    while (cap.read(frame)) {
-        cvtColor(frame, gray, COLOR_BGR2GRAY);  // Conversion en niveaux de gris
-
-        if (!first_frame) {
-            absdiff(prev_gray, gray, diff);  // Différence entre les images
-            threshold(diff, diff, 25, 255, THRESH_BINARY);  // Application d'un seuil
-            
-            // Trouver les contours des zones de mouvement
-            vector<vector<Point>> contours;  // Utilisation de std::vector
-            findContours(diff, contours, RETR_EXTERNAL, CHAIN_APPROX_SIMPLE);
-
-            for (size_t i = 0; i < contours.size(); i++) {
-                Moments m = moments(contours[i]);
-                if (m.m00 > 0) {  // Si le contour a une zone non nulle
-                    int x = static_cast<int>(m.m10 / m.m00);  // Coordonnée x du centre
-                    int y = static_cast<int>(m.m01 / m.m00);  // Coordonnée y du centre
-                    printf("Mouvement détecté dans %s à la position : (%d, %d)\n", video_path, x, y);
+// Sorties visuelles choisies en ligne de commande (--headless, --annotate <dossier>)
+static OutputOptions output_options;
 
-                    // Dessiner le contour et le centre du mouvement détecté sur l'image
-                    drawContours(frame, contours, (int)i, Scalar(0, 255, 0), 2);  // Dessiner les contours en vert
-                    circle(frame, Point(x, y), 5, Scalar(0, 0, 255), -1);  // Cercle rouge au centre du mouvement
-                    
-                    // Afficher la position sur l'image
-                    char text[50];
-                    snprintf(text, sizeof(text), "Pos: (%d, %d)", x, y);
-                    putText(frame, text, Point(x + 10, y + 10), FONT_HERSHEY_SIMPLEX, 0.7, Scalar(255, 0, 0), 2);  // Texte bleu
-                }
-            }
-        }
+// Paramètres du détecteur choisis en ligne de commande (cf. parse_motion_config)
+static MotionConfig motion_config;
 
-        // Afficher l'image avec les contours et les positions détectées
-        imshow("Mouvement Détecté", frame);
-        if (waitKey(30) >= 0) break;  // Sortir si une touche est pressée
+int detect_movement(const char *video_path) {
+    printf("Traitement de la vidéo : %s dans le processus %d\n", video_path, getpid());
 
-        gray.copyTo(prev_gray);
-        first_frame = false;
-    }
+    // Un détecteur par processus, réutilisé d'une vidéo à l'autre
+    static MotionDetector detector(motion_config);
+    ConsoleSink printer(false, true);
+    AnnotationSink annotation(output_options);
+    SinkChain sinks;
+    sinks.add(&printer);
+    sinks.add(&annotation);
 
-    cap.release();
-    return 0;
+    return run_video(video_path, detector, &sinks) < 0 ? -1 : 0;
 }
 
-int main() {
-    clock_t start_time = clock();  // Démarrer le chronomètre
+int main(int argc, char **argv) {
+    double start_time = wall_time();  // Démarrer le chronomètre
+    output_options = parse_output_options(argc, argv);
+    motion_config = parse_motion_config(argc, argv);
     
     struct dirent *entry;
     DIR *dir = opendir("videos");  // Ouvrir le dossier contenant les vidéos
@@ -74,28 +46,33 @@ int main() {
         return 1;
     }
 
+    // Processus de travail créés une fois (un par cœur disponible, --workers <n>) : ils
+    // prennent les vidéos dans la file commune au lieu d'un fork par fichier. Les threads
+    // OpenCV et décodeur de chaque processus suivent le budget (hérité au fork) : un
+    // worker par processus, donc un pool OpenCV de la taille de sa part.
+    ThreadBudget budget = parse_thread_budget(argc, argv, 0, 0, 1);
+    apply_thread_budget(budget);
+    print_thread_budget(budget);
+    ProcessPool pool(detect_movement, budget.workers);
+
     // Lire chaque fichier dans le dossier "videos"
     while ((entry = readdir(dir)) != NULL) {
         if (entry->d_type == DT_REG) {  // Si c'est un fichier (pas un dossier)
             char filepath[512];
             snprintf(filepath, sizeof(filepath), "videos/%s", entry->d_name);
-            
-            pid_t pid = fork();
-            if (pid == 0) {
-                // Processus enfant
-                detect_movement(filepath);
-                _exit(0); // Termine le processus enfant
-            }
+            pool.submit(filepath);
         }
     }
 
-    // Attendre la fin de tous les processus enfants
-    while (wait(NULL) > 0);
+    // Attendre la fin de toutes les vidéos
+    int failed = pool.wait();
+    if (failed > 0) {
+        printf("%d vidéo(s) en échec\n", failed);
+    }
 
     closedir(dir);
 
-    clock_t end_time = clock();  // Fin du chronomètre
-    double elapsed_time = ((double)(end_time - start_time)) / CLOCKS_PER_SEC;
+    double elapsed_time = wall_time() - start_time;  // Fin du chronomètre
     printf("Temps total d'exécution (Multiprocessus) : %.2f secondes\n", elapsed_time);
 
     return 0;
@@ -7,81 +7,117 @@
 #include <time.h>
 #include <unistd.h>
 #include <vector>  // Pour les vecteurs
+#include "motion_engine.hpp"
+#include "result_ring.hpp"
+#include "motion_query.hpp"
 
 using namespace cv;
 using namespace std;
 
-int detect_movement(const char *video_path, int pipe_fd) {
-    printf("Traitement de la vidéo : %s dans le processus %d\n", video_path, getpid());
-    VideoCapture cap(video_path);
-    if (!cap.isOpened()) {
-        fprintf(stderr, "Erreur lors de l'ouverture de la vidéo %s\n", video_path);
-        return -1;
-    }
+// Sorties visuelles choisies en ligne de commande (--headless, --annotate <dossier>)
+static OutputOptions output_options;
 
-    Mat frame, gray, prev_gray, diff;
-    bool first_frame = true;
-    bool movement_detected = false;
-
-    while (cap.read(frame)) {
-        cvtColor(frame, gray, COLOR_BGR2GRAY);
-        if (!first_frame) {
-            absdiff(prev_gray, gray, diff);  // Calcul de la différence
-            threshold(diff, diff, 25, 255, THRESH_BINARY);  // Seuillage
-            int movement_pixels = countNonZero(diff);  // Nombre de pixels affectés par le mouvement
-
-            if (movement_pixels > 0) {
-                movement_detected = true;
-
-                // Trouver les contours du mouvement
-                vector<vector<Point>> contours;
-                findContours(diff, contours, RETR_EXTERNAL, CHAIN_APPROX_SIMPLE);
-                
-                // Dessiner les contours et afficher les informations
-                for (size_t i = 0; i < contours.size(); i++) {
-                    Moments m = moments(contours[i]);
-                    if (m.m00 > 0) {
-                        int x = static_cast<int>(m.m10 / m.m00);  // Coordonnée x du centre
-                        int y = static_cast<int>(m.m01 / m.m00);  // Coordonnée y du centre
-                        
-                        // Dessiner le contour et le centre du mouvement détecté
-                        drawContours(frame, contours, (int)i, Scalar(0, 255, 0), 2);  // Dessiner les contours en vert
-                        circle(frame, Point(x, y), 5, Scalar(0, 0, 255), -1);  // Cercle rouge au centre
-                        
-                        // Afficher la position du centre sur l'image
-                        char text[50];
-                        snprintf(text, sizeof(text), "Pos: (%d, %d)", x, y);
-                        putText(frame, text, Point(x + 10, y + 10), FONT_HERSHEY_SIMPLEX, 0.7, Scalar(255, 0, 0), 2);  // Texte bleu
-                    }
-                }
+// Paramètres du détecteur choisis en ligne de commande (cf. parse_motion_config)
+static MotionConfig motion_config;
 
-                // Afficher le nombre de pixels affectés par le mouvement
-                dprintf(pipe_fd, "Mouvement détecté dans %s, Nombre de pixels affectés : %d\n", video_path, movement_pixels);
-                break;  // Sortir dès qu'un mouvement est détecté
-            }
+// --query any|first : réponse oui/non par sondage des images clés (cf. motion_query.hpp)
+static QueryMode query_mode;
+
+#define RING_CAPACITY 1024  // Enregistrements dans la file partagée
+#define BATCH_SIZE 64       // Enregistrements lus par le parent à chaque lot
+
+// Sortie qui envoie les résultats au processus parent par la file en mémoire partagée
+// (enregistrements binaires entiers, sans appel système par résultat)
+class RingSink : public MotionSink {
+public:
+    explicit RingSink(ResultRing *ring) : ring_(ring) {}
+
+    bool on_frame(const char *video_path, Mat &frame, const FrameResult &result) override {
+        (void)frame;
+        if (result.movement_pixels > 0) {
+            // Nombre de pixels affectés par le mouvement
+            ring_->push(make_result_record(RESULT_PIXELS, video_path, result.frame_index, result.movement_pixels));
         }
+        return true;
+    }
 
-        gray.copyTo(prev_gray);
-        first_frame = false;
+    void end_video(const char *video_path, bool movement_detected) override {
+        // Si un mouvement a été détecté, prévenir le parent
+        if (movement_detected) {
+            ring_->push(make_result_record(RESULT_VIDEO_DONE, video_path, -1, 1));
+        }
+    }
 
-        // Afficher l'image avec les contours et le centre (pour voir la vidéo)
-        imshow("Mouvement détecté", frame);
-        if (waitKey(30) >= 0) { // Attendre 30ms, et fermer si une touche est pressée
-            break;
+private:
+    ResultRing *ring_;
+};
+
+// Affiche un enregistrement reçu d'un processus enfant
+static void print_record(const ResultRecord &record) {
+    if (record.kind == RESULT_PIXELS) {
+        printf("Mouvement détecté dans %s, Nombre de pixels affectés : %d\n", record.video, record.pixels);
+    } else if (record.kind == RESULT_VIDEO_DONE) {
+        if (record.frame >= 0) {
+            printf("Mouvement détecté dans %s (image %d)\n", record.video, record.frame);
+        } else {
+            printf("Mouvement détecté dans %s\n", record.video);
+        }
+    } else if (record.kind == RESULT_QUERY) {
+        MotionQuery query;
+        query.motion = record.pixels != 0;
+        query.frame = record.frame;
+        query.time = record.time;
+        query.decoded_frames = record.decoded_frames;
+        query.total_frames = record.total_frames;
+        query.probes = record.probes;
+        print_motion_query(record.video, query);
+        if (query.motion) {
+            printf("Mouvement détecté dans %s (image %d)\n", record.video, record.frame);
         }
     }
+}
 
-    cap.release();
+int detect_movement(const char *video_path, ResultRing *ring) {
+    printf("Traitement de la vidéo : %s dans le processus %d\n", video_path, getpid());
 
-    // Si un mouvement a été détecté, envoyer un message au parent via le pipe
-    if (movement_detected) {
-        dprintf(pipe_fd, "Mouvement détecté dans %s\n", video_path);
+    if (query_mode != QUERY_OFF) {
+        // Sans décoder depuis le début : images clés sondées, puis affinage autour du mouvement
+        MotionQuery query;
+        if (!query_motion(video_path, motion_config, query_mode, query)) {
+            return -1;
+        }
+        // Réponse affichée par le parent : la sortie de l'enfant n'est pas vidée par _exit
+        ResultRecord record = make_result_record(RESULT_QUERY, video_path, (int)query.frame, query.motion ? 1 : 0);
+        record.time = query.time;
+        record.decoded_frames = query.decoded_frames;
+        record.total_frames = query.total_frames;
+        record.probes = query.probes;
+        ring->push(record);
+        return 0;
     }
-    return 0;
+
+    MotionConfig config = motion_config;
+    config.stop_at_first = !config.full_analysis;  // Sortir dès qu'un mouvement est détecté (sauf --full)
+    MotionDetector detector(config);
+
+    RingSink ring_sink(ring);
+    AnnotationSink annotation(output_options, "Mouvement détecté");
+    SinkChain sinks;
+    sinks.add(&ring_sink);
+    sinks.add(&annotation);
+
+    return run_video(video_path, detector, &sinks) < 0 ? -1 : 0;
 }
 
-int main() {
-    clock_t start_time = clock();
+int main(int argc, char **argv) {
+    double start_time = wall_time();
+    output_options = parse_output_options(argc, argv);
+    motion_config = parse_motion_config(argc, argv);
+    query_mode = parse_query_mode(argc, argv);
+    if (motion_config.full_analysis && query_mode != QUERY_OFF) {
+        fprintf(stderr, "--full : analyse complète, --query ignoré\n");
+        query_mode = QUERY_OFF;
+    }
     
     struct dirent *entry;
     DIR *dir = opendir("videos");
@@ -90,50 +126,67 @@ int main() {
         return 1;
     }
 
-    // Créer un pipe pour la communication entre les processus parent et enfant
-    int pipe_fd[2];
-    if (pipe(pipe_fd) == -1) {
-        perror("Erreur lors de la création du pipe");
+    // File partagée pour la communication entre les processus enfants et le parent (créée avant fork)
+    ResultRing ring(RING_CAPACITY);
+    if (!ring.is_open()) {
         return 1;
     }
+    int children = 0;
 
     while ((entry = readdir(dir)) != NULL) {
         if (entry->d_type == DT_REG) {
             char filepath[512];
             snprintf(filepath, sizeof(filepath), "videos/%s", entry->d_name);
             
+            fflush(stdout);  // Sinon le tampon du parent serait recopié, puis écrit, par chaque enfant
             pid_t pid = fork();
             if (pid == 0) {
-                // Processus enfant : fermer le côté lecture du pipe
-                close(pipe_fd[0]);
-                
-                // Effectuer la détection de mouvement et envoyer le résultat au pipe
-                detect_movement(filepath, pipe_fd[1]);
-                
-                // Fermer le côté écriture et sortir
-                close(pipe_fd[1]);
+                // Processus enfant : effectuer la détection de mouvement et publier les résultats.
+                // Les lignes que run_video écrit lui-même (cache, --alloc-stats, --io-stats) sont
+                // vidées avant _exit, qui ne vide pas les tampons de stdio.
+                detect_movement(filepath, &ring);
+                fflush(stdout);
                 _exit(0);
+            } else if (pid > 0) {
+                children++;
             }
         }
     }
 
-    // Processus parent : fermer le côté écriture du pipe
-    close(pipe_fd[1]);
+    // Processus parent : lire les enregistrements par lots jusqu'à la fin de tous les enfants
+    ResultRecord batch[BATCH_SIZE];
+    for (;;) {
+        size_t count = ring.pop(batch, BATCH_SIZE);
+        for (size_t i = 0; i < count; i++) {
+            print_record(batch[i]);
+        }
+        if (count > 0) {
+            continue;
+        }
 
-    // Lire les messages du pipe
-    char buffer[512];
-    while (read(pipe_fd[0], buffer, sizeof(buffer)) > 0) {
-        printf("%s", buffer);
+        pid_t pid;
+        int status;
+        while (children > 0 && (pid = waitpid(-1, &status, WNOHANG)) > 0) {
+            children--;
+            if (WIFSIGNALED(status) && ring.recover(pid) > 0) {
+                fprintf(stderr, "Processus %d tué pendant une publication : emplacement repris\n", (int)pid);
+            }
+        }
+        if (children == 0) {
+            // Tous les enfants sont terminés : plus rien ne peut être publié après ce dernier lot
+            while ((count = ring.pop(batch, BATCH_SIZE)) > 0) {
+                for (size_t i = 0; i < count; i++) {
+                    print_record(batch[i]);
+                }
+            }
+            break;
+        }
+        ring.wait(100);  // Réveillé par le futex à la prochaine publication
     }
 
-    // Fermer le côté lecture du pipe et attendre la fin de tous les processus enfants
-    close(pipe_fd[0]);
-    while (wait(NULL) > 0);
-
     closedir(dir);
 
-    clock_t end_time = clock();
-    double elapsed_time = ((double)(end_time - start_time)) / CLOCKS_PER_SEC;
+    double elapsed_time = wall_time() - start_time;
     printf("Temps total d'exécution (Multiprocessus avec Pipe) : %.2f secondes\n", elapsed_time);
 
     return 0;
@@ -6,73 +6,44 @@
 #include <opencv2/opencv.hpp>
 #include <time.h>
 #include <vector>  // Pour les vecteurs
+#include "motion_engine.hpp"
+#include "thread_pool.hpp"
+#include "thread_budget.hpp"
+#include "event_log.hpp"
+#include "video_segments.hpp"
 
 using namespace cv;
 using namespace std;
 
+// Sorties visuelles choisies en ligne de commande (--headless, --annotate <dossier>)
+static OutputOptions output_options;
+
+// Paramètres du détecteur choisis en ligne de commande (cf. parse_motion_config)
+static MotionConfig motion_config;
+
+// Durée minimale d'un segment quand une vidéo est découpée entre plusieurs threads
+#define MIN_SEGMENT_SECONDS 30.0
+
 void *detect_movement(void *arg) {
     const char *video_path = (const char *)arg;
     printf("Traitement de la vidéo dans un thread : %s\n", video_path);
-    VideoCapture cap(video_path);
-    if (!cap.isOpened()) {
-        fprintf(stderr, "Erreur lors de l'ouverture de la vidéo %s\n", video_path);
-        pthread_exit(NULL);
-    }
-
-    Mat frame, gray, prev_gray, diff;
-    bool first_frame = true;
-
-    while (cap.read(frame)) {
-        cvtColor(frame, gray, COLOR_BGR2GRAY);  // Conversion en niveaux de gris
-
-        if (!first_frame) {
-            absdiff(prev_gray, gray, diff);  // Différence entre les images
-            threshold(diff, diff, 25, 255, THRESH_BINARY);  // Application d'un seuil
-            
-            // Nombre de pixels affectés par le mouvement
-            int movement_pixels = countNonZero(diff);  
-            if (movement_pixels > 0) {
-                printf("Mouvement détecté dans %s, Nombre de pixels affectés : %d\n", video_path, movement_pixels);
-
-                // Trouver les contours des zones de mouvement
-                vector<vector<Point>> contours;
-                findContours(diff, contours, RETR_EXTERNAL, CHAIN_APPROX_SIMPLE);
-
-                // Dessiner les contours et afficher les informations
-                for (size_t i = 0; i < contours.size(); i++) {
-                    Moments m = moments(contours[i]);
-                    if (m.m00 > 0) {
-                        int x = static_cast<int>(m.m10 / m.m00);  // Coordonnée x du centre
-                        int y = static_cast<int>(m.m01 / m.m00);  // Coordonnée y du centre
-                        printf("Mouvement détecté à la position : (%d, %d)\n", x, y);
-
-                        // Dessiner le contour et le centre du mouvement détecté sur l'image
-                        drawContours(frame, contours, (int)i, Scalar(0, 255, 0), 2);  // Dessiner les contours en vert
-                        circle(frame, Point(x, y), 5, Scalar(0, 0, 255), -1);  // Cercle rouge au centre du mouvement
-                        
-                        // Afficher la position du centre sur l'image
-                        char text[50];
-                        snprintf(text, sizeof(text), "Pos: (%d, %d)", x, y);
-                        putText(frame, text, Point(x + 10, y + 10), FONT_HERSHEY_SIMPLEX, 0.7, Scalar(255, 0, 0), 2);  // Texte bleu
-                    }
-                }
-            }
-        }
-
-        // Afficher l'image avec les contours et les positions détectées
-        imshow("Mouvement Détecté", frame);
-        if (waitKey(30) >= 0) break;  // Sortir si une touche est pressée
 
-        gray.copyTo(prev_gray);
-        first_frame = false;
-    }
+    // Un détecteur par worker, réutilisé d'une vidéo à l'autre (tampons déjà alloués)
+    static thread_local MotionDetector detector(motion_config);
+    EventLogSink printer(true, true);  // Écrit par lots par le thread du journal
+    AnnotationSink annotation(output_options);
+    SinkChain sinks;
+    sinks.add(&printer);
+    sinks.add(&annotation);
 
-    cap.release();
-    pthread_exit(NULL);
+    run_video(video_path, detector, &sinks);
+    return NULL;
 }
 
-int main() {
-    clock_t start_time = clock();
+int main(int argc, char **argv) {
+    double start_time = wall_time();
+    output_options = parse_output_options(argc, argv);
+    motion_config = parse_motion_config(argc, argv);
 
     struct dirent *entry;
     DIR *dir = opendir("videos");
@@ -95,22 +66,46 @@ int main() {
 
     closedir(dir);
 
-    // Créer des threads pour chaque vidéo
-    vector<pthread_t> threads(video_files.size());
+    // Journal des détections (--events <fichier>, --events-binary), écrit par son propre thread
+    if (!event_log_open(parse_event_log_options(argc, argv))) {
+        return 1;
+    }
+
+    // Répartir les vidéos sur un pool de threads de taille fixe (un thread par cœur disponible)
+    // Taille et threads internes (OpenCV, décodeur) fixés par le budget de threads :
+    // --workers <n>, --cv-threads <n>, --decoder-threads <n>, --pin
+    ThreadBudget budget = parse_thread_budget(argc, argv, 0);
+    apply_thread_budget(budget);
+    print_thread_budget(budget);
+    ThreadPool pool(budget.workers, pin_pool_worker, &budget);
+    // Écrit par lots par le thread du journal ; un canal par vidéo garde l'ordre des images
+    // quand les segments d'une vidéo sont transmis par plusieurs threads
+    EventLogSink printer(true, true, true);
+    const char *reason = NULL;
+    bool segmented = !output_options.display && !output_options.annotate_dir &&
+                     segments_supported(motion_config, &reason);
+    if (reason) {
+        printf("%s : vidéos traitées en entier, sans découpage en segments\n", reason);
+    }
     for (size_t i = 0; i < video_files.size(); i++) {
-        pthread_create(&threads[i], NULL, detect_movement, video_files[i]);
+        if (!segmented) {
+            pool.submit(detect_movement, video_files[i]);
+        } else {
+            // Analyse seule : les longues vidéos sont découpées aux images clés entre les threads
+            submit_segmented_video(pool, video_files[i], motion_config, &printer, MIN_SEGMENT_SECONDS);
+        }
     }
 
-    // Attendre la fin de tous les threads
-    for (size_t i = 0; i < threads.size(); i++) {
-        pthread_join(threads[i], NULL);
-        free(video_files[i]);  // Libérer la mémoire après que le thread ait terminé
+    // Attendre la fin de toutes les vidéos
+    pool.wait();
+    event_log_close();
+    for (size_t i = 0; i < video_files.size(); i++) {
+        free(video_files[i]);  // Libérer la mémoire après le traitement
     }
 
     video_files.clear();  // Vider le vector
 
-    clock_t end_time = clock();
-    double elapsed_time = ((double)(end_time - start_time)) / CLOCKS_PER_SEC;
+    double elapsed_time = wall_time() - start_time;
     printf("Temps total d'exécution (Multithreads Parallèle) : %.2f secondes\n", elapsed_time);
 
     return 0;
@@ -5,73 +5,105 @@
 #include <pthread.h>
 #include <opencv2/opencv.hpp>
 #include <time.h>
+#include <signal.h>
+#include <atomic>
+#include <string>
 #include <vector>  // Utilisation de std::vector
+#include "dir_watch.hpp"
+#include "motion_engine.hpp"
+#include "thread_pool.hpp"
+#include "thread_budget.hpp"
+#include "event_log.hpp"
 
 using namespace cv;
 using namespace std;
 
+// Sorties visuelles choisies en ligne de commande (--headless, --annotate <dossier>)
+static OutputOptions output_options;
+
+// Paramètres du détecteur choisis en ligne de commande (cf. parse_motion_config)
+static MotionConfig motion_config;
+
 void *detect_movement(void *arg) {
     const char *video_path = (const char *)arg;
     printf("Traitement de la vidéo dans un thread : %s\n", video_path);
-    VideoCapture cap(video_path);
-    if (!cap.isOpened()) {
-        fprintf(stderr, "Erreur lors de l'ouverture de la vidéo %s\n", video_path);
-        pthread_exit(NULL);
-    }
 
-    Mat frame, gray, prev_gray, diff;
-    bool first_frame = true;
-
-    while (cap.read(frame)) {
-        cvtColor(frame, gray, COLOR_BGR2GRAY);  // Conversion en niveaux de gris
-
-        if (!first_frame) {
-            absdiff(prev_gray, gray, diff);  // Différence entre les images
-            threshold(diff, diff, 25, 255, THRESH_BINARY);  // Application d'un seuil
-            
-            int movement_pixels = countNonZero(diff);  // Compter les pixels affectés par le mouvement
-            if (movement_pixels > 0) {
-                printf("Mouvement détecté dans %s, Nombre de pixels affectés : %d\n", video_path, movement_pixels);
-                
-                // Trouver les contours des zones de mouvement
-                vector<vector<Point>> contours;
-                findContours(diff, contours, RETR_EXTERNAL, CHAIN_APPROX_SIMPLE);
-
-                // Dessiner les contours et afficher les informations
-                for (size_t i = 0; i < contours.size(); i++) {
-                    Moments m = moments(contours[i]);
-                    if (m.m00 > 0) {
-                        int x = static_cast<int>(m.m10 / m.m00);  // Coordonnée x du centre
-                        int y = static_cast<int>(m.m01 / m.m00);  // Coordonnée y du centre
-                        printf("Mouvement détecté à la position : (%d, %d)\n", x, y);
-
-                        // Dessiner le contour et le centre du mouvement détecté sur l'image
-                        drawContours(frame, contours, (int)i, Scalar(0, 255, 0), 2);  // Dessiner les contours en vert
-                        circle(frame, Point(x, y), 5, Scalar(0, 0, 255), -1);  // Cercle rouge au centre du mouvement
-                        
-                        // Afficher la position du centre sur l'image
-                        char text[50];
-                        snprintf(text, sizeof(text), "Pos: (%d, %d)", x, y);
-                        putText(frame, text, Point(x + 10, y + 10), FONT_HERSHEY_SIMPLEX, 0.7, Scalar(255, 0, 0), 2);  // Texte bleu
-                    }
-                }
-            }
-        }
+    // Un détecteur par worker, réutilisé d'une vidéo à l'autre (tampons déjà alloués)
+    static thread_local MotionDetector detector(motion_config);
+    EventLogSink printer(true, true);  // Écrit par lots par le thread du journal
+    AnnotationSink annotation(output_options);
+    SinkChain sinks;
+    sinks.add(&printer);
+    sinks.add(&annotation);
+
+    run_video(video_path, detector, &sinks);
+    return NULL;
+}
+
+// Mode service (--watch) : vidéo arrivée dans le dossier et heure de son arrivée
+struct Arrival {
+    char path[512];
+    double time;
+    DirWatcher *watcher;  // Prévenu de la fin de l'analyse (réécritures pendant celle-ci)
+};
 
-        // Afficher l'image avec les contours et les positions détectées
-        imshow("Mouvement Détecté", frame);
-        if (waitKey(30) >= 0) break;  // Sortir si une touche est pressée
+// Délai arrivée -> résultat des vidéos traitées en mode service
+static std::atomic<int> watch_videos(0);
+static std::atomic<long long> watch_latency_sum_us(0), watch_latency_max_us(0);
 
-        gray.copyTo(prev_gray);
-        first_frame = false;
+// Arrêt du service demandé (SIGINT, SIGTERM)
+static volatile sig_atomic_t stop_requested = 0;
+
+static void request_stop(int sig) {
+    (void)sig;
+    stop_requested = 1;
+}
+
+void *detect_arrival(void *arg) {
+    Arrival *arrival = (Arrival *)arg;
+    detect_movement(arrival->path);
+
+    double latency = wall_time() - arrival->time;
+    long long latency_us = (long long)(latency * 1e6);
+    long long max_us = watch_latency_max_us.load();
+    while (latency_us > max_us && !watch_latency_max_us.compare_exchange_weak(max_us, latency_us)) {
     }
+    watch_latency_sum_us += latency_us;
+    watch_videos++;
+    printf("%s : résultat %.3f s après l'arrivée\n", arrival->path, latency);
+    arrival->watcher->done(arrival->path);
+    free(arrival);
+    return NULL;
+}
 
-    cap.release();
-    pthread_exit(NULL);
+static void submit_arrival(ThreadPool &pool, DirWatcher *watcher, const char *path, double time) {
+    Arrival *arrival = (Arrival *)malloc(sizeof(Arrival));
+    snprintf(arrival->path, sizeof(arrival->path), "%s", path);
+    arrival->time = time;
+    arrival->watcher = watcher;
+    pool.submit(detect_arrival, arrival);
 }
 
-int main() {
-    clock_t start_time = clock();
+int main(int argc, char **argv) {
+    double start_time = wall_time();
+    output_options = parse_output_options(argc, argv);
+    motion_config = parse_motion_config(argc, argv);
+
+    // Mode service : surveillance mise en place avant la lecture du dossier pour ne perdre
+    // aucune arrivée (une vidéo fermée pendant la lecture peut être traitée deux fois)
+    bool watch = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--watch") == 0) {
+            watch = true;
+        }
+    }
+    DirWatcher *watcher = NULL;
+    if (watch) {
+        watcher = new DirWatcher("videos");
+        if (!watcher->ok()) {
+            return 1;
+        }
+    }
 
     struct dirent *entry;
     DIR *dir = opendir("videos");
@@ -94,23 +126,67 @@ int main() {
 
     closedir(dir);
 
-    // Créer des threads pour chaque vidéo
-    vector<pthread_t> threads(video_files.size());
+    // Journal des détections (--events <fichier>, --events-binary), écrit par son propre thread
+    if (!event_log_open(parse_event_log_options(argc, argv))) {
+        return 1;
+    }
+
+    // Répartir les vidéos sur un pool de threads de taille fixe (un thread par cœur disponible)
+    // Taille et threads internes (OpenCV, décodeur) fixés par le budget de threads :
+    // --workers <n>, --cv-threads <n>, --decoder-threads <n>, --pin
+    // (en mode service, le nombre de vidéos n'est pas connu : pas de limite au nombre de workers)
+    ThreadBudget budget = parse_thread_budget(argc, argv, watch ? 0 : (int)video_files.size());
+    apply_thread_budget(budget);
+    print_thread_budget(budget);
+    ThreadPool pool(budget.workers, pin_pool_worker, &budget);
     for (size_t i = 0; i < video_files.size(); i++) {
-        pthread_create(&threads[i], NULL, detect_movement, video_files[i]);
+        if (watch) {
+            if (watcher->claim(video_files[i])) {
+                submit_arrival(pool, watcher, video_files[i], start_time);
+            }
+        } else {
+            pool.submit(detect_movement, video_files[i]);
+        }
     }
 
-    // Attendre la fin de tous les threads
-    for (size_t i = 0; i < threads.size(); i++) {
-        pthread_join(threads[i], NULL);
-        free(video_files[i]);  // Libérer la mémoire après que le thread ait terminé
+    if (watch) {
+        // Sans SA_RESTART : le signal interrompt l'attente des événements
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_handler = request_stop;
+        sigaction(SIGINT, &action, NULL);
+        sigaction(SIGTERM, &action, NULL);
+
+        printf("Surveillance du dossier videos (Ctrl+C pour arrêter)\n");
+        while (!stop_requested) {
+            std::string path;
+            double arrival;
+            if (watcher->next(path, arrival, 1000)) {
+                submit_arrival(pool, watcher, path.c_str(), arrival);  // Aussitôt en file : pas d'attente d'un lot
+            }
+        }
+        printf("Arrêt du service : fin des vidéos en cours\n");
+    }
+
+    // Attendre la fin de toutes les vidéos
+    pool.wait();
+    event_log_close();
+    if (watch) {
+        delete watcher;
+        int count = watch_videos.load();
+        if (count > 0) {
+            printf("%d vidéo(s) en mode service, délai arrivée -> résultat : moyen %.3f s, max %.3f s\n", count,
+                   watch_latency_sum_us.load() * 1e-6 / count, watch_latency_max_us.load() * 1e-6);
+        }
+    }
+    for (size_t i = 0; i < video_files.size(); i++) {
+        free(video_files[i]);  // Libérer la mémoire après le traitement
     }
 
     video_files.clear();  // Vider le vector
 
-    clock_t end_time = clock();
-    double elapsed_time = ((double)(end_time - start_time)) / CLOCKS_PER_SEC;
-    printf("Temps total d'exécution (Multithreads Parallèle) : %.2f secondes\n", elapsed_time);
+    double elapsed_time = wall_time() - start_time;
+    printf("Temps total d'exécution (Multithreads Séquentiel) : %.2f secondes\n", elapsed_time);
 
     return 0;
 }
@@ -1,115 +1,404 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
 #include <unistd.h>
 #include <pthread.h>
 #include <semaphore.h>
+#include <stdint.h>
+#include <time.h>
+#include <map>
+#include <vector>
 #include <opencv2/opencv.hpp>
+#include "motion_engine.hpp"
+#include "thread_budget.hpp"
+#include "video_reader.hpp"
 
-#define BUFFER_SIZE 5  // Taille du buffer
+using namespace cv;
 
-int buffer[BUFFER_SIZE]; // Buffer partagé
-int in = 0;              // Indice d'ajout dans le buffer
-int out = 0;             // Indice de retrait dans le buffer
+// Pipeline décodage -> analyse -> sortie :
+//   - un thread producteur décode la vidéo dans des tampons d'images réutilisés
+//   - un ou plusieurs threads consommateurs analysent les images (paire image / image précédente)
+//   - un thread de sortie remet les résultats dans l'ordre des images et les affiche
+// Le décodage et l'analyse se recouvrent ; la profondeur de la file montre la contre-pression.
+
+#define BUFFER_SIZE 8          // Taille du buffer (file décodage -> analyse)
+#define RESULT_BUFFER_SIZE 16  // Taille de la file analyse -> sortie
+#define MAX_ANALYSERS 16
+
+// Tampon d'image du pool, partagé par l'analyse de l'image et celle de l'image suivante
+struct FrameBuffer {
+    Mat luma;
+    int refs;
+};
+
+// Élément du buffer : une image à analyser (index -1 : fin du flux)
+struct FrameJob {
+    int index;
+    FrameBuffer *cur;
+    FrameBuffer *prev;  // NULL pour la première image
+};
+
+FrameJob buffer[BUFFER_SIZE]; // Buffer partagé
+int in = 0;                   // Indice d'ajout dans le buffer
+int out = 0;                  // Indice de retrait dans le buffer
 
 sem_t empty; // Semaphore pour les emplacements vides
 sem_t full;  // Semaphore pour les emplacements remplis
 sem_t mutex; // Semaphore pour la mutualisation d'accès
 
-// Fonction du Producteur
+// Pool de tampons d'images (alloués une fois, réutilisés d'une image à l'autre)
+std::vector<FrameBuffer> frame_pool;
+std::vector<FrameBuffer *> free_frames;
+sem_t frames_available; // Tampons libres
+sem_t pool_mutex;       // Accès exclusif à free_frames
+
+// File des résultats (analyse -> sortie), remis dans l'ordre par le thread de sortie
+FrameResult results[RESULT_BUFFER_SIZE];
+bool results_end[RESULT_BUFFER_SIZE];
+int results_in = 0;
+int results_out = 0;
+sem_t results_empty;
+sem_t results_full;
+sem_t results_mutex;
+
+const char *current_video = NULL;
+int num_analysers = 1;
+volatile bool pipeline_done = false;
+
+// Statistiques de contre-pression
+long depth_sum = 0;          // Somme des profondeurs de file observées à chaque ajout
+int depth_max = 0;
+int frames_decoded = 0;
+double producer_blocked = 0; // Temps passé par le producteur à attendre une place libre (s)
+double consumer_starved = 0; // Temps passé par les consommateurs à attendre une image (s)
+pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static OutputOptions output_options;
+
+// Répartition des cœurs : un worker du budget par thread d'analyse (cf. thread_budget.hpp)
+static ThreadBudget budget;
+
+// Paramètres du détecteur choisis en ligne de commande (cf. parse_motion_config)
+static MotionConfig motion_config;
+
+// sem_wait en mesurant le temps bloqué (0 si une place était disponible immédiatement)
+static double timed_sem_wait(sem_t *sem) {
+    if (sem_trywait(sem) == 0) {
+        return 0.0;
+    }
+    double start = wall_time();
+    sem_wait(sem);
+    return wall_time() - start;
+}
+
+static FrameBuffer *acquire_frame() {
+    sem_wait(&frames_available);
+    sem_wait(&pool_mutex);
+    FrameBuffer *frame = free_frames.back();
+    free_frames.pop_back();
+    sem_post(&pool_mutex);
+    return frame;
+}
+
+static void release_frame(FrameBuffer *frame) {
+    if (!frame) {
+        return;
+    }
+    sem_wait(&pool_mutex);
+    bool last = --frame->refs == 0;
+    if (last) {
+        free_frames.push_back(frame);
+    }
+    sem_post(&pool_mutex);
+    if (last) {
+        sem_post(&frames_available);
+    }
+}
+
+static void push_job(const FrameJob &job) {
+    // Attente pour un emplacement vide
+    double blocked = timed_sem_wait(&empty);
+
+    // Accès exclusif au buffer
+    sem_wait(&mutex);
+    buffer[in] = job;
+    in = (in + 1) % BUFFER_SIZE; // Met à jour l'indice d'ajout
+    sem_post(&mutex);
+
+    // Signal qu'il y a un nouvel élément dans le buffer
+    sem_post(&full);
+
+    int depth;
+    sem_getvalue(&full, &depth);
+    pthread_mutex_lock(&stats_lock);
+    producer_blocked += blocked;
+    depth_sum += depth;
+    if (depth > depth_max) {
+        depth_max = depth;
+    }
+    pthread_mutex_unlock(&stats_lock);
+}
+
+static void push_result(const FrameResult &result, bool end) {
+    sem_wait(&results_empty);
+    sem_wait(&results_mutex);
+    results[results_in] = result;
+    results_end[results_in] = end;
+    results_in = (results_in + 1) % RESULT_BUFFER_SIZE;
+    sem_post(&results_mutex);
+    sem_post(&results_full);
+}
+
+// Fonction du Producteur : décode la vidéo dans les tampons du pool
 void* producer(void* arg) {
-    int item;
-    for (int i = 0; i < 10; i++) {
-        item = rand() % 100; // Génère un élément aléatoire
+    (void)arg;
+    VideoReader reader;
+    if (!reader.open(current_video)) {
+        fprintf(stderr, "Erreur lors de l'ouverture de la vidéo %s\n", current_video);
+    } else {
+        Mat luma;
+        FrameBuffer *prev = NULL;
+        int index = 0;
 
-        // Attente pour un emplacement vide
-        sem_wait(&empty);
+        while (reader.read_luma(luma)) {
+            FrameBuffer *frame = acquire_frame();
+            luma.copyTo(frame->luma);  // Le décodeur réutilise son propre tampon
+            frame->refs = 2;           // Analyse de l'image + analyse de l'image suivante
 
-        // Accès exclusif au buffer
-        sem_wait(&mutex);
-        buffer[in] = item;
-        printf("Producteur produit : %d à l'emplacement %d\n", item, in);
-        in = (in + 1) % BUFFER_SIZE; // Met à jour l'indice d'ajout
-        sem_post(&mutex);
+            push_job(FrameJob{index++, frame, prev});
+            prev = frame;
+        }
+        release_frame(prev);  // Aucune image suivante n'utilisera la dernière
 
-        // Signal qu'il y a un nouvel élément dans le buffer
-        sem_post(&full);
+        pthread_mutex_lock(&stats_lock);
+        frames_decoded = index;
+        pthread_mutex_unlock(&stats_lock);
+    }
 
-        sleep(1); // Pause pour simuler un délai de production
+    // Un marqueur de fin par consommateur
+    for (int i = 0; i < num_analysers; i++) {
+        push_job(FrameJob{-1, NULL, NULL});
     }
     return NULL;
 }
 
-// Fonction du Consommateur
+// Fonction du Consommateur : analyse les images dans l'ordre où elles arrivent
 void* consumer(void* arg) {
-    int item;
-    for (int i = 0; i < 10; i++) {
+    pin_worker(budget, (int)(intptr_t)arg);  // arg : indice du thread d'analyse
+    MotionDetector detector(motion_config);
+    FrameResult result;
+
+    for (;;) {
         // Attente pour un emplacement rempli
-        sem_wait(&full);
+        double starved = timed_sem_wait(&full);
 
         // Accès exclusif au buffer
         sem_wait(&mutex);
-        item = buffer[out];
-        printf("Consommateur consomme : %d depuis l'emplacement %d\n", item, out);
+        FrameJob job = buffer[out];
         out = (out + 1) % BUFFER_SIZE; // Met à jour l'indice de retrait
         sem_post(&mutex);
 
         // Signal qu'il y a un emplacement vide
         sem_post(&empty);
 
-        sleep(1); // Pause pour simuler un délai de consommation
+        pthread_mutex_lock(&stats_lock);
+        consumer_starved += starved;
+        pthread_mutex_unlock(&stats_lock);
+
+        if (job.index < 0) {
+            break;
+        }
+
+        detector.process_pair(job.cur->luma, job.prev ? job.prev->luma : Mat(), result);
+        result.frame_index = job.index;
+        result.contours = NULL;  // Les contours appartiennent au détecteur de ce thread
+        release_frame(job.prev);
+        release_frame(job.cur);
+
+        push_result(result, false);
+    }
+
+    push_result(FrameResult(), true);
+    return NULL;
+}
+
+// Thread de sortie : remet les résultats dans l'ordre des images
+void* sink(void* arg) {
+    MotionSink *motion_sink = (MotionSink *)arg;
+    std::map<int, FrameResult> pending;
+    int next_index = 0;
+    int ended = 0;
+    bool movement_detected = false;
+    Mat no_frame;
+
+    motion_sink->begin_video(current_video);
+    while (ended < num_analysers) {
+        sem_wait(&results_full);
+        sem_wait(&results_mutex);
+        FrameResult result = results[results_out];
+        bool end = results_end[results_out];
+        results_out = (results_out + 1) % RESULT_BUFFER_SIZE;
+        sem_post(&results_mutex);
+        sem_post(&results_empty);
+
+        if (end) {
+            ended++;
+            continue;
+        }
+        pending[result.frame_index] = result;
+
+        // Transmettre tous les résultats devenus consécutifs
+        std::map<int, FrameResult>::iterator it;
+        while ((it = pending.find(next_index)) != pending.end()) {
+            movement_detected = movement_detected || it->second.movement_pixels > 0;
+            motion_sink->on_frame(current_video, no_frame, it->second);
+            pending.erase(it);
+            next_index++;
+        }
     }
+    motion_sink->end_video(current_video, movement_detected);
     return NULL;
 }
 
-void display_buffer(int* buffer) {
+void display_buffer(FrameJob* buffer) {
     // Crée une image avec OpenCV pour afficher l'état du buffer
     cv::Mat img = cv::Mat::zeros(500, 1000, CV_8UC3); // Image vide pour l'affichage
-    int x = 50; // Position de départ sur l'axe X
+    int x = 20; // Position de départ sur l'axe X
+    int filled;
+    sem_getvalue(&full, &filled);
+
+    sem_wait(&mutex);
     for (int i = 0; i < BUFFER_SIZE; i++) {
-        // Dessiner chaque élément du buffer
-        cv::Scalar color = (buffer[i] > 0) ? cv::Scalar(0, 255, 0) : cv::Scalar(0, 0, 255);  // Vert si rempli, rouge si vide
+        // Un emplacement est rempli s'il se trouve entre out et in
+        bool used = ((i - out + BUFFER_SIZE) % BUFFER_SIZE) < filled;
+        cv::Scalar color = used ? cv::Scalar(0, 255, 0) : cv::Scalar(0, 0, 255);  // Vert si rempli, rouge si vide
         cv::rectangle(img, cv::Point(x, 200), cv::Point(x + 100, 300), color, -1);
-        cv::putText(img, std::to_string(buffer[i]), cv::Point(x + 35, 250), cv::FONT_HERSHEY_SIMPLEX, 0.8, cv::Scalar(0, 0, 0), 2);
-        x += 150;  // Espace entre les éléments
+        if (used) {
+            cv::putText(img, std::to_string(buffer[i].index), cv::Point(x + 15, 250), cv::FONT_HERSHEY_SIMPLEX, 0.8, cv::Scalar(0, 0, 0), 2);
+        }
+        x += 120;  // Espace entre les éléments
     }
-    
+    sem_post(&mutex);
+
     // Affichage de l'image avec l'état du buffer
     cv::imshow("Buffer", img);
     cv::waitKey(1); // Mise à jour de l'affichage en temps réel
 }
 
-int main() {
+// Traite une vidéo avec le pipeline complet
+void process_video(const char *video_path, MotionSink *motion_sink) {
+    printf("Traitement de la vidéo : %s (%d thread(s) d'analyse)\n", video_path, num_analysers);
+    current_video = video_path;
+    in = out = results_in = results_out = 0;
+    depth_sum = depth_max = frames_decoded = 0;
+    producer_blocked = consumer_starved = 0;
+    pipeline_done = false;
+
     // Initialisation des sémaphores
     sem_init(&empty, 0, BUFFER_SIZE); // Au départ, tous les emplacements sont vides
     sem_init(&full, 0, 0);            // Aucun emplacement rempli au départ
     sem_init(&mutex, 0, 1);           // Accès exclusif (1) pour le buffer
+    sem_init(&results_empty, 0, RESULT_BUFFER_SIZE);
+    sem_init(&results_full, 0, 0);
+    sem_init(&results_mutex, 0, 1);
 
-    pthread_t producer_thread, consumer_thread;
+    // Tampons nécessaires : images dans la file et en analyse, plus l'image précédente du producteur
+    frame_pool.assign(BUFFER_SIZE + num_analysers + 2, FrameBuffer());
+    free_frames.clear();
+    for (size_t i = 0; i < frame_pool.size(); i++) {
+        free_frames.push_back(&frame_pool[i]);
+    }
+    sem_init(&frames_available, 0, frame_pool.size());
+    sem_init(&pool_mutex, 0, 1);
+
+    pthread_t producer_thread, sink_thread;
+    pthread_t consumer_threads[MAX_ANALYSERS];
+    double start = wall_time();
 
-    // Création des threads de producteur et consommateur
+    // Création des threads de producteur, consommateurs et sortie
     pthread_create(&producer_thread, NULL, producer, NULL);
-    pthread_create(&consumer_thread, NULL, consumer, NULL);
+    for (int i = 0; i < num_analysers; i++) {
+        pthread_create(&consumer_threads[i], NULL, consumer, (void *)(intptr_t)i);
+    }
+    pthread_create(&sink_thread, NULL, sink, motion_sink);
 
     // Affichage du buffer pendant l'exécution des threads
-    while (true) {
-        display_buffer(buffer);
-        usleep(100000);  // Attendre 0.1 seconde avant de rafraîchir
+    if (output_options.display) {
+        while (!pipeline_done) {
+            display_buffer(buffer);
+            usleep(100000);  // Attendre 0.1 seconde avant de rafraîchir
+            pipeline_done = pthread_tryjoin_np(sink_thread, NULL) == 0;
+        }
+    } else {
+        pthread_join(sink_thread, NULL);
     }
 
     // Attente de la fin des threads
     pthread_join(producer_thread, NULL);
-    pthread_join(consumer_thread, NULL);
+    for (int i = 0; i < num_analysers; i++) {
+        pthread_join(consumer_threads[i], NULL);
+    }
+    double elapsed = wall_time() - start;
+
+    printf("%s : %d images en %.2f s (%.1f images/s)\n", video_path, frames_decoded, elapsed,
+           elapsed > 0 ? frames_decoded / elapsed : 0.0);
+    printf("  File décodage -> analyse : profondeur moyenne %.1f / %d, max %d\n",
+           frames_decoded > 0 ? (double)depth_sum / frames_decoded : 0.0, BUFFER_SIZE, depth_max);
+    printf("  Producteur bloqué (file pleine) : %.2f s, consommateurs en attente (file vide) : %.2f s\n",
+           producer_blocked, consumer_starved);
 
     // Destruction des sémaphores
     sem_destroy(&empty);
     sem_destroy(&full);
     sem_destroy(&mutex);
+    sem_destroy(&results_empty);
+    sem_destroy(&results_full);
+    sem_destroy(&results_mutex);
+    sem_destroy(&frames_available);
+    sem_destroy(&pool_mutex);
+}
+
+int main(int argc, char **argv) {
+    output_options = parse_output_options(argc, argv);
+    motion_config = parse_motion_config(argc, argv);
+
+    // Threads d'analyse : workers du budget (--workers <n>, ou --analysers <n>), quota cgroup
+    // compris. Par défaut un cœur pour le décodage, un pour la sortie, le reste pour l'analyse.
+    int analysers = available_cpus() - 2;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--analysers") == 0 && i + 1 < argc) {
+            analysers = atoi(argv[++i]);
+        }
+    }
+    budget = parse_thread_budget(argc, argv, MAX_ANALYSERS, analysers > 1 ? analysers : 1);
+    apply_thread_budget(budget);
+    print_thread_budget(budget);
+    num_analysers = budget.workers;
+
+    struct dirent *entry;
+    DIR *dir = opendir("videos");
+    if (dir == NULL) {
+        printf("Impossible d'ouvrir le dossier de vidéos\n");
+        return 1;
+    }
+
+    ConsoleSink printer(true, true);
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_type == DT_REG) {
+            char filepath[512];
+            snprintf(filepath, sizeof(filepath), "videos/%s", entry->d_name);
+            process_video(filepath, &printer);
+        }
+    }
+    closedir(dir);
 
     printf("Production et consommation terminées.\n");
 
     // Fermeture de toutes les fenêtres OpenCV
-    cv::destroyAllWindows();
+    if (output_options.display) {
+        cv::destroyAllWindows();
+    }
 
     return 0;
 }
-
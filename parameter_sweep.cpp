@@ -0,0 +1,74 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <dirent.h>
+#include <string.h>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+#include "motion_engine.hpp"
+#include "motion_sweep.hpp"
+
+using namespace std;
+
+// Balayage de paramètres : chaque vidéo de videos/ est décodée une seule fois et
+// chaque image alimente toutes les configurations (cf. motion_sweep.hpp) :
+//   ./parameter_sweep --sweep-threshold 15,25,35 --sweep-min-area 0,50 --sweep-sample 1,4 --sweep-out sweep
+// Les paramètres non balayés viennent de parse_motion_config (--threshold, --min-area, ...).
+
+int main(int argc, char **argv) {
+    double start_time = wall_time();
+    MotionConfig base = parse_motion_config(argc, argv);
+    vector<MotionConfig> configs = parse_sweep_configs(argc, argv, base);
+    if (configs.empty()) {
+        fprintf(stderr, "Aucune configuration à évaluer\n");
+        return 1;
+    }
+
+    MotionSweep sweep(configs);
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--sweep-out") == 0 && !sweep.open_outputs(argv[i + 1])) {
+            return 1;
+        }
+    }
+
+    struct dirent *entry;
+    DIR *dir = opendir("videos");
+    if (dir == NULL) {
+        printf("Impossible d'ouvrir le dossier de vidéos\n");
+        return 1;
+    }
+
+    int64_t total_frames = 0;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_type == DT_REG) {
+            char filepath[512];
+            snprintf(filepath, sizeof(filepath), "videos/%s", entry->d_name);
+            double video_start = wall_time();
+            int64_t frames = run_sweep(filepath, sweep);
+            if (frames >= 0) {
+                printf("%s : %lld images décodées une fois pour %zu configuration(s) (%.2f s)\n", filepath,
+                       (long long)frames, configs.size(), wall_time() - video_start);
+                total_frames += frames;
+            }
+        }
+    }
+    closedir(dir);
+
+    // Un jeu de résultats par configuration
+    printf("\n%4s %6s %8s %7s %-10s %-8s %10s %10s %7s %10s %12s\n", "#", "seuil", "aire min", "échant.", "zones",
+           "centre", "analysées", "mouvement", "vidéos", "zones", "pixels/img");
+    for (size_t i = 0; i < sweep.size(); i++) {
+        const MotionConfig &c = sweep.config(i);
+        const SweepStats &s = sweep.stats(i);
+        printf("%4zu %6d %8d %7d %-10s %-8s %10lld %10lld %7d %10lld %12.1f\n", i, c.threshold, c.min_area,
+               c.sample_every, c.regions == REGIONS_CONTOURS ? "contours" : "composantes",
+               c.centroid == CENTROID_MOMENTS ? "moments" : "boîte", (long long)s.frames_analysed,
+               (long long)s.frames_with_motion, s.videos_with_motion, (long long)s.regions,
+               s.frames_with_motion > 0 ? (double)s.movement_pixels / s.frames_with_motion : 0.0);
+    }
+
+    double elapsed_time = wall_time() - start_time;
+    printf("Temps total d'exécution (Balayage de paramètres, %lld images) : %.2f secondes\n", (long long)total_frames,
+           elapsed_time);
+    return 0;
+}
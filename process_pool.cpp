@@ -0,0 +1,240 @@
+#include "process_pool.hpp"
+#include "thread_pool.hpp"
+
+#include <errno.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+
+enum { JOB_STARTED = 1, JOB_DONE = 2 };
+
+// Message de tâche : lu en entier par un seul processus (écriture atomique < PIPE_BUF)
+struct JobMessage {
+    uint32_t id;
+    char arg[PROCESS_JOB_SIZE - sizeof(uint32_t)];
+};
+
+// Message d'un processus de travail vers le parent
+struct DoneMessage {
+    int32_t kind;
+    int32_t pid;
+    uint32_t id;
+    int32_t status;  // Résultat de la fonction (JOB_DONE)
+};
+
+static bool write_all(int fd, const void *data, size_t size) {
+    ssize_t n;
+    do {
+        n = write(fd, data, size);
+    } while (n < 0 && errno == EINTR);
+    return n == (ssize_t)size;
+}
+
+ProcessPool::ProcessPool(job_fn fn, int num_workers)
+    : fn_(fn), num_workers_(num_workers > 0 ? num_workers : ThreadPool::hardware_threads()),
+      next_id_(0), failed_(0), lost_check_(false) {
+    if (pipe(job_pipe_) == -1 || pipe(done_pipe_) == -1) {
+        perror("Erreur lors de la création du pipe");
+        num_workers_ = 0;
+        return;
+    }
+    for (int i = 0; i < num_workers_; i++) {
+        spawn();
+    }
+}
+
+ProcessPool::~ProcessPool() {
+    wait();
+    if (num_workers_ == 0 && workers_.empty()) {
+        return;
+    }
+
+    // Fin de la file : chaque processus lit EOF et se termine
+    close(job_pipe_[1]);
+    for (set<pid_t>::iterator it = workers_.begin(); it != workers_.end(); ++it) {
+        waitpid(*it, NULL, 0);
+    }
+    close(job_pipe_[0]);
+    close(done_pipe_[0]);
+    close(done_pipe_[1]);
+}
+
+pid_t ProcessPool::spawn() {
+    fflush(stdout);  // Ne pas dupliquer le tampon de sortie du parent dans l'enfant
+    pid_t pid = fork();
+    if (pid == 0) {
+        worker_main();
+        _exit(0);
+    }
+    if (pid < 0) {
+        perror("Erreur lors de la création du processus");
+        return pid;
+    }
+    workers_.insert(pid);
+    return pid;
+}
+
+void ProcessPool::worker_main() {
+    close(job_pipe_[1]);  // Sinon EOF n'arriverait jamais
+    close(done_pipe_[0]);
+
+    JobMessage job;
+    for (;;) {
+        ssize_t n = read(job_pipe_[0], &job, sizeof(job));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n != (ssize_t)sizeof(job)) {
+            break;  // EOF : plus de tâches
+        }
+
+        DoneMessage msg = {JOB_STARTED, (int32_t)getpid(), job.id, 0};
+        write_all(done_pipe_[1], &msg, sizeof(msg));
+
+        msg.kind = JOB_DONE;
+        msg.status = fn_(job.arg);
+        fflush(stdout);
+        write_all(done_pipe_[1], &msg, sizeof(msg));
+    }
+}
+
+void ProcessPool::submit(const char *arg) {
+    pending_.push_back(arg);
+}
+
+void ProcessPool::dispatch() {
+    // Au plus deux tâches d'avance par processus (et jamais plus que le pipe ne contient)
+    size_t limit = 2 * (size_t)num_workers_;
+    if (limit > 65536 / PROCESS_JOB_SIZE) {
+        limit = 65536 / PROCESS_JOB_SIZE;
+    }
+    while (!pending_.empty() && sent_.size() < limit) {
+        JobMessage job;
+        memset(&job, 0, sizeof(job));
+        job.id = next_id_++;
+        strncpy(job.arg, pending_.front().c_str(), sizeof(job.arg) - 1);
+        if (!write_all(job_pipe_[1], &job, sizeof(job))) {
+            perror("Erreur lors de l'envoi d'une tâche");
+            return;
+        }
+        sent_[job.id] = pending_.front();
+        pending_.pop_front();
+    }
+}
+
+void ProcessPool::finish(unsigned id, bool ok) {
+    map<unsigned, string>::iterator it = sent_.find(id);
+    if (it == sent_.end()) {
+        return;
+    }
+    if (!ok) {
+        failed_++;
+    }
+    sent_.erase(it);
+}
+
+bool ProcessPool::collect(int timeout_ms) {
+    struct pollfd pfd = {done_pipe_[0], POLLIN, 0};
+    if (poll(&pfd, 1, timeout_ms) <= 0) {
+        return false;
+    }
+
+    // Les messages sont écrits entiers : la lecture en contient toujours un nombre entier
+    DoneMessage msgs[64];
+    ssize_t n = read(done_pipe_[0], msgs, sizeof(msgs));
+    if (n <= 0) {
+        return false;
+    }
+    for (size_t i = 0; i < (size_t)n / sizeof(DoneMessage); i++) {
+        const DoneMessage &msg = msgs[i];
+        if (msg.kind == JOB_STARTED) {
+            running_[msg.pid] = msg.id;
+        } else {
+            running_.erase(msg.pid);
+            finish(msg.id, msg.status >= 0);
+        }
+    }
+    return true;
+}
+
+void ProcessPool::reap() {
+    int status;
+    pid_t pid;
+    while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+        if (!workers_.erase(pid)) {
+            continue;
+        }
+        while (collect(0)) {
+            // Lire les messages écrits par le processus avant sa fin
+        }
+
+        // Un processus ne se termine de lui-même qu'en fin de file : ici, il a planté
+        map<pid_t, unsigned>::iterator it = running_.find(pid);
+        if (it != running_.end()) {
+            map<unsigned, string>::iterator job = sent_.find(it->second);
+            if (job != sent_.end()) {
+                if (WIFSIGNALED(status)) {
+                    fprintf(stderr, "Échec de %s : processus %d terminé par le signal %d\n", job->second.c_str(), pid,
+                            WTERMSIG(status));
+                } else {
+                    fprintf(stderr, "Échec de %s : processus %d terminé (code %d)\n", job->second.c_str(), pid,
+                            WEXITSTATUS(status));
+                }
+            }
+            finish(it->second, false);
+            running_.erase(it);
+        } else {
+            lost_check_ = true;
+        }
+        spawn();  // Remplaçant : le nombre de processus reste constant
+    }
+}
+
+int ProcessPool::wait() {
+    if (num_workers_ == 0) {
+        return failed_;
+    }
+
+    while (!pending_.empty() || !sent_.empty()) {
+        if (workers_.empty() && spawn() < 0) {
+            // Aucun processus vivant et fork impossible : personne ne lira plus la file
+            for (map<unsigned, string>::iterator it = sent_.begin(); it != sent_.end(); ++it) {
+                fprintf(stderr, "Échec de %s : aucun processus de travail\n", it->second.c_str());
+                failed_++;
+            }
+            for (size_t i = 0; i < pending_.size(); i++) {
+                fprintf(stderr, "Échec de %s : aucun processus de travail\n", pending_[i].c_str());
+                failed_++;
+            }
+            sent_.clear();
+            running_.clear();
+            pending_.clear();
+            break;
+        }
+        dispatch();
+        collect(100);
+        reap();
+
+        if (lost_check_ && running_.empty()) {
+            // Aucun processus n'a de tâche en cours et la file est vide : les tâches
+            // envoyées restantes ont été lues par un processus mort avant de la signaler
+            int queued = 0;
+            ioctl(job_pipe_[0], FIONREAD, &queued);
+            if (queued == 0) {
+                for (map<unsigned, string>::iterator it = sent_.begin(); it != sent_.end(); ++it) {
+                    fprintf(stderr, "Échec de %s : tâche perdue par un processus terminé\n", it->second.c_str());
+                    failed_++;
+                }
+                sent_.clear();
+            }
+            lost_check_ = false;
+        }
+    }
+    return failed_;
+}
@@ -0,0 +1,64 @@
+#ifndef PROCESS_POOL_HPP
+#define PROCESS_POOL_HPP
+
+// Pool de processus de travail créés à l'avance (pre-fork).
+//
+// Au lieu d'un fork par vidéo, N processus de longue durée prennent les vidéos
+// dans une file de tâches commune (un pipe de messages de taille fixe, écrits et
+// lus en une seule opération atomique) et signalent le début et la fin de chaque
+// tâche au parent. La mémoire reste bornée et l'initialisation d'OpenCV et des
+// décodeurs n'est payée qu'une fois par processus. L'isolation est conservée :
+// si un processus plante, sa tâche est comptée en échec et un remplaçant est créé.
+// Si plus aucun processus ne vit et qu'aucun ne peut être créé (fork en échec),
+// les tâches restantes sont comptées en échec au lieu d'attendre indéfiniment.
+
+#include <sys/types.h>
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+
+#define PROCESS_JOB_SIZE 512  // Taille d'un message de tâche (inférieure à PIPE_BUF : écriture atomique)
+
+class ProcessPool {
+public:
+    // Fonction exécutée dans un processus de travail ; le résultat est remonté au parent
+    typedef int (*job_fn)(const char *arg);
+
+    // num_workers <= 0 : un processus par cœur. Les processus sont créés immédiatement.
+    explicit ProcessPool(job_fn fn, int num_workers = 0);
+    ~ProcessPool();  // Attend la fin des tâches puis arrête les processus
+    ProcessPool(const ProcessPool &) = delete;
+    ProcessPool &operator=(const ProcessPool &) = delete;
+
+    // Ajoute une tâche (arg : chaîne de moins de PROCESS_JOB_SIZE - 4 octets)
+    void submit(const char *arg);
+
+    // Distribue les tâches et attend leur fin ; retourne le nombre de tâches en échec
+    // (résultat négatif, processus terminé anormalement ou aucun processus disponible)
+    int wait();
+
+    int size() const { return num_workers_; }
+
+private:
+    pid_t spawn();
+    void worker_main();
+    void dispatch();
+    bool collect(int timeout_ms);
+    void reap();
+    void finish(unsigned id, bool ok);
+
+    job_fn fn_;
+    int num_workers_;
+    int job_pipe_[2];   // Parent -> processus : tâches
+    int done_pipe_[2];  // Processus -> parent : début et fin de tâche
+    std::deque<std::string> pending_;       // Tâches pas encore envoyées
+    std::map<unsigned, std::string> sent_;  // Tâches envoyées et pas encore terminées
+    std::map<pid_t, unsigned> running_;     // Tâche en cours de chaque processus (d'après ses messages)
+    std::set<pid_t> workers_;
+    unsigned next_id_;
+    int failed_;
+    bool lost_check_;  // Un processus est mort sans tâche connue : il a pu emporter un message lu
+};
+
+#endif // PROCESS_POOL_HPP
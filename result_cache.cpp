@@ -0,0 +1,294 @@
+#include "result_cache.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define HASH_PRIME1 0x9E3779B185EBCA87ULL
+#define HASH_PRIME2 0xC2B2AE3D27D4EB4FULL
+#define HASH_PRIME3 0x165667B19E3779F9ULL
+#define HASH_CHUNK (1 << 20)
+
+static inline uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t hash_round(uint64_t acc, uint64_t word) {
+    acc += word * HASH_PRIME2;
+    return rotl64(acc, 31) * HASH_PRIME1;
+}
+
+static inline uint64_t hash_final(uint64_t h) {
+    h ^= h >> 33;
+    h *= HASH_PRIME2;
+    h ^= h >> 29;
+    h *= HASH_PRIME3;
+    return h ^ (h >> 32);
+}
+
+// Empreinte 64 bits incrémentale : quatre accumulateurs sur des blocs de 32 octets
+// (indépendants, le processeur les calcule en parallèle), octets restants à part
+struct ContentHash {
+    uint64_t lanes[4];
+    unsigned char tail[32];
+    size_t tail_size;
+    uint64_t length;
+
+    ContentHash() : tail_size(0), length(0) {
+        lanes[0] = HASH_PRIME1 + HASH_PRIME2;
+        lanes[1] = HASH_PRIME2;
+        lanes[2] = 0;
+        lanes[3] = 0 - HASH_PRIME1;
+    }
+
+    void stripe(const unsigned char *p) {
+        for (int i = 0; i < 4; i++) {
+            uint64_t word;
+            memcpy(&word, p + 8 * i, 8);
+            lanes[i] = hash_round(lanes[i], word);
+        }
+    }
+
+    void update(const unsigned char *data, size_t size) {
+        length += size;
+        if (tail_size > 0) {
+            size_t n = 32 - tail_size < size ? 32 - tail_size : size;
+            memcpy(tail + tail_size, data, n);
+            tail_size += n;
+            data += n;
+            size -= n;
+            if (tail_size < 32) {
+                return;
+            }
+            stripe(tail);
+            tail_size = 0;
+        }
+        while (size >= 32) {
+            stripe(data);
+            data += 32;
+            size -= 32;
+        }
+        memcpy(tail, data, size);
+        tail_size = size;
+    }
+
+    uint64_t digest() const {
+        uint64_t h = rotl64(lanes[0], 1) + rotl64(lanes[1], 7) + rotl64(lanes[2], 12) + rotl64(lanes[3], 18);
+        h ^= length * HASH_PRIME3;
+        for (size_t i = 0; i < tail_size; i++) {
+            h = rotl64(h ^ (tail[i] * HASH_PRIME3), 11) * HASH_PRIME1;
+        }
+        return hash_final(h);
+    }
+};
+
+static uint64_t hash_string(const char *text) {
+    ContentHash hash;
+    hash.update((const unsigned char *)text, strlen(text));
+    return hash.digest();
+}
+
+// Lit tout le fichier ; false en cas d'erreur de lecture
+static bool hash_file(int fd, uint64_t &content) {
+    unsigned char *buffer = (unsigned char *)malloc(HASH_CHUNK);
+    if (!buffer) {
+        return false;
+    }
+    ContentHash hash;
+    bool ok = true;
+    for (;;) {
+        ssize_t n = read(fd, buffer, HASH_CHUNK);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            ok = false;
+            break;
+        }
+        if (n == 0) {
+            break;
+        }
+        hash.update(buffer, (size_t)n);
+    }
+    free(buffer);
+    content = hash.digest();
+    return ok;
+}
+
+// Écrit text dans path par renommage d'un fichier temporaire (jamais de fichier à moitié écrit)
+static void write_atomic(const char *path, const char *text) {
+    char tmp[PATH_MAX];
+    snprintf(tmp, sizeof(tmp), "%s.tmp.%d.%lx", path, (int)getpid(), (unsigned long)pthread_self());
+    FILE *file = fopen(tmp, "w");
+    if (!file) {
+        return;
+    }
+    bool ok = fputs(text, file) >= 0;
+    ok = fclose(file) == 0 && ok;
+    if (!ok || rename(tmp, path) != 0) {
+        unlink(tmp);
+    }
+}
+
+static bool make_dir(const char *path) {
+    return mkdir(path, 0755) == 0 || errno == EEXIST;
+}
+
+ResultCache::ResultCache(const char *dir) {
+    snprintf(dir_, sizeof(dir_), "%s", dir);
+    char files[PATH_MAX];
+    snprintf(files, sizeof(files), "%s/files", dir_);
+    ok_ = make_dir(dir_) && make_dir(files);
+    if (!ok_) {
+        fprintf(stderr, "Impossible de créer le dossier du cache %s : %s\n", dir_, strerror(errno));
+    }
+}
+
+bool ResultCache::key(const char *video_path, const MotionConfig &config, CacheKey &key) {
+    int fd = open(video_path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+    key.size = st.st_size;
+    key.params = config_hash(config);
+
+    // Empreinte mémorisée par fichier (chemin absolu), valable tant que le fichier n'a pas changé
+    char absolute[PATH_MAX], index[PATH_MAX];
+    if (!realpath(video_path, absolute)) {
+        snprintf(absolute, sizeof(absolute), "%s", video_path);
+    }
+    snprintf(index, sizeof(index), "%s/files/%016llx", dir_, (unsigned long long)hash_string(absolute));
+
+    FILE *file = fopen(index, "r");
+    if (file) {
+        unsigned long long dev, ino, content;
+        long long size, mtime_sec, mtime_nsec;
+        int n = fscanf(file, "%llu %llu %lld %lld %lld %llx", &dev, &ino, &size, &mtime_sec, &mtime_nsec, &content);
+        fclose(file);
+        if (n == 6 && dev == (unsigned long long)st.st_dev && ino == (unsigned long long)st.st_ino &&
+            size == (long long)st.st_size && mtime_sec == (long long)st.st_mtim.tv_sec &&
+            mtime_nsec == (long long)st.st_mtim.tv_nsec) {
+            key.content = content;
+            close(fd);
+            return true;
+        }
+    }
+
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    bool ok = hash_file(fd, key.content);
+    close(fd);
+    if (!ok) {
+        return false;
+    }
+
+    char text[256];
+    snprintf(text, sizeof(text), "%llu %llu %lld %lld %lld %016llx\n", (unsigned long long)st.st_dev,
+             (unsigned long long)st.st_ino, (long long)st.st_size, (long long)st.st_mtim.tv_sec,
+             (long long)st.st_mtim.tv_nsec, (unsigned long long)key.content);
+    write_atomic(index, text);
+    return true;
+}
+
+void ResultCache::entry_path(const CacheKey &key, const char *suffix, char *path, size_t size) const {
+    snprintf(path, size, "%s/%016llx-%lld-%016llx%s", dir_, (unsigned long long)key.content, (long long)key.size,
+             (unsigned long long)key.params, suffix);
+}
+
+int ResultCache::lock(const CacheKey &key) {
+    char path[PATH_MAX];
+    entry_path(key, ".lock", path, sizeof(path));
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return -1;
+    }
+    while (flock(fd, LOCK_EX) != 0) {
+        if (errno != EINTR) {
+            close(fd);
+            return -1;
+        }
+    }
+    return fd;
+}
+
+void ResultCache::unlock(int fd) {
+    if (fd >= 0) {
+        close(fd);  // Libère le verrou (le fichier .lock reste, il est réutilisé)
+    }
+}
+
+bool ResultCache::lookup(const CacheKey &key, CachedResult &result) {
+    char path[PATH_MAX];
+    entry_path(key, ".res", path, sizeof(path));
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        return false;
+    }
+    int motion;
+    long long frames, motion_frames, first_motion;
+    int n = fscanf(file, "%d %lld %lld %lld", &motion, &frames, &motion_frames, &first_motion);
+    fclose(file);
+    if (n != 4) {
+        return false;
+    }
+    result.motion = motion != 0;
+    result.frames = frames;
+    result.motion_frames = motion_frames;
+    result.first_motion = first_motion;
+    return true;
+}
+
+void ResultCache::store(const CacheKey &key, const CachedResult &result) {
+    char path[PATH_MAX], text[128];
+    entry_path(key, ".res", path, sizeof(path));
+    snprintf(text, sizeof(text), "%d %lld %lld %lld\n", result.motion ? 1 : 0, (long long)result.frames,
+             (long long)result.motion_frames, (long long)result.first_motion);
+    write_atomic(path, text);
+}
+
+static ResultCache *g_result_cache = nullptr;
+
+void result_cache_enable(const char *dir) {
+    ResultCache *cache = new ResultCache(dir);
+    if (!cache->ok()) {
+        delete cache;
+        return;
+    }
+    delete g_result_cache;
+    g_result_cache = cache;
+}
+
+ResultCache *result_cache() {
+    return g_result_cache;
+}
+
+uint64_t config_hash(const MotionConfig &config) {
+    char text[256];
+    snprintf(text, sizeof(text), "v1 t=%d c=%d r=%d a=%d k=%d s=%d b=%d be=%d mv=%.6f f=%d st=%d", config.threshold,
+             (int)config.centroid, (int)config.regions, config.min_area, config.coarse_scale, config.sample_every,
+             config.burst_frames, (int)config.backend, config.mv_threshold, config.find_regions ? 1 : 0,
+             config.stop_at_first ? 1 : 0);
+    return hash_string(text);
+}
+
+void print_cached_result(const char *video_path, const CachedResult &result) {
+    if (result.motion) {
+        printf("%s : résultat en cache, mouvement dès l'image %lld (%lld image(s) en mouvement sur %lld analysée(s))\n",
+               video_path, (long long)result.first_motion, (long long)result.motion_frames,
+               (long long)result.frames);
+    } else {
+        printf("%s : résultat en cache, aucun mouvement (%lld image(s) analysée(s))\n", video_path,
+               (long long)result.frames);
+    }
+}
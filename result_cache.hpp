@@ -0,0 +1,78 @@
+#ifndef RESULT_CACHE_HPP
+#define RESULT_CACHE_HPP
+
+// Cache persistant des résultats par vidéo.
+//
+// Chaque exécution retraitait toutes les vidéos du dossier, y compris celles déjà
+// analysées avec les mêmes paramètres et les copies identiques octet pour octet
+// (« second_0620.mp4 » et « second_0621 (copie).mp4 »). Le résultat d'une vidéo est
+// rangé sous une clé « empreinte du contenu + taille + empreinte des paramètres » :
+// une vidéo renommée ou copiée retrouve le même résultat, et changer un paramètre
+// du détecteur donne une autre clé.
+//
+// L'empreinte du contenu (64 bits, lecture complète du fichier, bien moins chère que
+// le décodage) est elle-même mémorisée par fichier avec son périphérique, son inode,
+// sa taille et sa date de modification : une vidéo inchangée n'est pas relue.
+//
+// Le cache est un dossier de petits fichiers texte écrits par renommage atomique,
+// partageable entre threads et processus. Un verrou flock par clé fait attendre le
+// second worker d'une copie pendant que le premier l'analyse : il trouve ensuite le
+// résultat au lieu d'analyser la copie en parallèle. Le verrou est libéré par le
+// noyau si le processus meurt.
+
+#include "motion_engine.hpp"
+
+#include <stdint.h>
+
+// Résultat mémorisé d'une vidéo
+struct CachedResult {
+    bool motion = false;           // Mouvement détecté
+    int64_t frames = 0;            // Images analysées
+    int64_t motion_frames = 0;     // Images analysées avec du mouvement
+    int64_t first_motion = -1;     // Première image en mouvement, -1 si aucune
+};
+
+// Clé d'une vidéo pour une configuration du détecteur
+struct CacheKey {
+    uint64_t content = 0;   // Empreinte du contenu
+    int64_t size = 0;       // Taille du fichier (octets)
+    uint64_t params = 0;    // Empreinte des paramètres
+};
+
+class ResultCache {
+public:
+    explicit ResultCache(const char *dir);
+
+    // false si le dossier du cache ne peut pas être créé
+    bool ok() const { return ok_; }
+    const char *dir() const { return dir_; }
+
+    // Calcule la clé d'une vidéo (empreinte mémorisée si le fichier n'a pas changé) ;
+    // false si le fichier ne peut pas être lu
+    bool key(const char *video_path, const MotionConfig &config, CacheKey &key);
+
+    // Verrou exclusif sur la clé (bloquant) ; retourne le descripteur à passer à unlock, -1 en cas d'échec
+    int lock(const CacheKey &key);
+    void unlock(int fd);
+
+    bool lookup(const CacheKey &key, CachedResult &result);
+    void store(const CacheKey &key, const CachedResult &result);
+
+private:
+    void entry_path(const CacheKey &key, const char *suffix, char *path, size_t size) const;
+
+    char dir_[256];
+    bool ok_;
+};
+
+// Cache utilisé par run_video (NULL : pas de cache) ; activé par --cache <dossier>
+void result_cache_enable(const char *dir);
+ResultCache *result_cache();
+
+// Empreinte des paramètres qui changent le résultat d'une vidéo
+uint64_t config_hash(const MotionConfig &config);
+
+// Affiche le résultat d'une vidéo trouvé dans le cache
+void print_cached_result(const char *video_path, const CachedResult &result);
+
+#endif // RESULT_CACHE_HPP
@@ -0,0 +1,209 @@
+#include "result_ring.hpp"
+
+#include <linux/futex.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#include <atomic>
+#include <new>
+
+using namespace std;
+
+// Emplacement de la file : seq indique à qui il appartient (file bornée de Vyukov)
+//   seq == position        : libre pour le producteur de cette position
+//   seq == position + 1    : publié, lisible par le consommateur
+//   owner                  : processus qui remplit l'emplacement réservé (0 : pas encore
+//                            revendiqué, SLOT_ABANDONED : repris par le parent, cf. recover)
+struct Slot {
+    atomic<uint32_t> seq;
+    atomic<int32_t> owner;
+    ResultRecord record;
+};
+
+#define SLOT_ABANDONED -1
+
+struct ResultRing::Shared {
+    atomic<uint32_t> enqueue_pos;
+    atomic<uint32_t> dequeue_pos;        // Seul le consommateur l'écrit
+    atomic<uint32_t> published;          // Mot futex : incrémenté à chaque publication
+    atomic<uint32_t> consumed;           // Mot futex : incrémenté à chaque lot lu
+    atomic<uint32_t> consumer_waiting;
+    atomic<uint32_t> producers_waiting;
+    uint32_t mask;
+    Slot slots[1];
+};
+
+// Futex partagé entre processus (pas de FUTEX_PRIVATE_FLAG : la page est MAP_SHARED)
+static void futex_wait(atomic<uint32_t> *word, uint32_t expected, int timeout_ms) {
+    struct timespec timeout;
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_nsec = (timeout_ms % 1000) * 1000000L;
+    syscall(SYS_futex, (uint32_t *)word, FUTEX_WAIT, expected, &timeout, NULL, 0);
+}
+
+static void futex_wake(atomic<uint32_t> *word, int count) {
+    syscall(SYS_futex, (uint32_t *)word, FUTEX_WAKE, count, NULL, NULL, 0);
+}
+
+ResultRing::ResultRing(uint32_t capacity) : shared_(nullptr), size_(0) {
+    uint32_t slots = 2;
+    while (slots < capacity) {
+        slots <<= 1;
+    }
+    size_ = sizeof(Shared) + (slots - 1) * sizeof(Slot);
+
+    void *memory = mmap(NULL, size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        perror("Erreur lors de la création de la mémoire partagée");
+        return;
+    }
+
+    shared_ = new (memory) Shared;
+    shared_->enqueue_pos.store(0);
+    shared_->dequeue_pos.store(0);
+    shared_->published.store(0);
+    shared_->consumed.store(0);
+    shared_->consumer_waiting.store(0);
+    shared_->producers_waiting.store(0);
+    shared_->mask = slots - 1;
+    for (uint32_t i = 0; i < slots; i++) {
+        new (&shared_->slots[i].seq) atomic<uint32_t>(i);
+        new (&shared_->slots[i].owner) atomic<int32_t>(0);
+    }
+}
+
+ResultRing::~ResultRing() {
+    if (shared_) {
+        munmap(shared_, size_);
+    }
+}
+
+void ResultRing::push(const ResultRecord &record) {
+    Shared *s = shared_;
+    uint32_t pos = s->enqueue_pos.load(memory_order_relaxed);
+    Slot *slot;
+
+    for (;;) {
+        slot = &s->slots[pos & s->mask];
+        int32_t diff = (int32_t)(slot->seq.load(memory_order_acquire) - pos);
+        if (diff == 0) {
+            // Emplacement libre : le réserver
+            if (s->enqueue_pos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) {
+                // Revendiquer l'emplacement ; perdu si le parent l'a repris entre-temps (recover)
+                int32_t unclaimed = 0;
+                if (slot->owner.compare_exchange_strong(unclaimed, (int32_t)getpid(), memory_order_acq_rel)) {
+                    break;
+                }
+                pos = s->enqueue_pos.load(memory_order_relaxed);
+            }
+        } else if (diff < 0) {
+            // File pleine : attendre que le parent lise un lot. consumed est lu avant
+            // la revérification : un lot lu entre-temps fait revenir futex_wait aussitôt.
+            uint32_t consumed = s->consumed.load(memory_order_acquire);
+            s->producers_waiting.fetch_add(1, memory_order_seq_cst);
+            if ((int32_t)(slot->seq.load(memory_order_acquire) - pos) < 0) {
+                futex_wait(&s->consumed, consumed, 100);
+            }
+            s->producers_waiting.fetch_sub(1);
+            pos = s->enqueue_pos.load(memory_order_relaxed);
+        } else {
+            pos = s->enqueue_pos.load(memory_order_relaxed);  // Pris par un autre producteur
+        }
+    }
+
+    slot->record = record;
+    slot->seq.store(pos + 1, memory_order_release);
+
+    // Appel système seulement si le parent dort
+    s->published.fetch_add(1, memory_order_seq_cst);
+    if (s->consumer_waiting.load(memory_order_seq_cst)) {
+        futex_wake(&s->published, 1);
+    }
+}
+
+size_t ResultRing::pop(ResultRecord *records, size_t max) {
+    Shared *s = shared_;
+    uint32_t pos = s->dequeue_pos.load(memory_order_relaxed);
+    size_t count = 0;
+    size_t consumed = 0;  // Emplacements libérés, abandonnés compris
+
+    while (count < max) {
+        Slot *slot = &s->slots[pos & s->mask];
+        if ((int32_t)(slot->seq.load(memory_order_acquire) - (pos + 1)) < 0) {
+            break;  // Pas encore publié
+        }
+        if (slot->record.kind != RESULT_NONE) {
+            records[count++] = slot->record;
+        }
+        slot->owner.store(0, memory_order_relaxed);
+        slot->seq.store(pos + s->mask + 1, memory_order_release);  // Libre pour le tour suivant
+        pos++;
+        consumed++;
+    }
+
+    if (consumed > 0) {
+        s->dequeue_pos.store(pos, memory_order_relaxed);
+        s->consumed.fetch_add(1, memory_order_seq_cst);
+        if (s->producers_waiting.load(memory_order_seq_cst)) {
+            futex_wake(&s->consumed, INT_MAX);
+        }
+    }
+    return count;
+}
+
+void ResultRing::wait(int timeout_ms) {
+    Shared *s = shared_;
+    uint32_t published = s->published.load(memory_order_acquire);
+    s->consumer_waiting.store(1, memory_order_seq_cst);
+
+    // Revérifier après s'être déclaré en attente : une publication entre-temps change published
+    Slot *slot = &s->slots[s->dequeue_pos.load(memory_order_relaxed) & s->mask];
+    if ((int32_t)(slot->seq.load(memory_order_acquire) - (s->dequeue_pos.load(memory_order_relaxed) + 1)) < 0) {
+        futex_wait(&s->published, published, timeout_ms);
+    }
+    s->consumer_waiting.store(0, memory_order_relaxed);
+}
+
+int ResultRing::recover(int pid) {
+    Shared *s = shared_;
+    uint32_t end = s->enqueue_pos.load(memory_order_acquire);
+    int recovered = 0;
+    for (uint32_t pos = s->dequeue_pos.load(memory_order_relaxed); pos != end; pos++) {
+        Slot *slot = &s->slots[pos & s->mask];
+        if (slot->seq.load(memory_order_acquire) != pos) {
+            continue;  // Publié (ou pas encore réservé)
+        }
+        // Réservé sans être publié : rempli par pid, ou pas encore revendiqué. Dans le second
+        // cas, la revendication est prise au producteur : s'il est vivant, il perd la sienne
+        // et réserve un autre emplacement.
+        int32_t owner = slot->owner.load(memory_order_acquire);
+        int32_t unclaimed = 0;
+        if (owner == pid ||
+            (owner == 0 && slot->owner.compare_exchange_strong(unclaimed, SLOT_ABANDONED, memory_order_acq_rel))) {
+            slot->record.kind = RESULT_NONE;
+            slot->seq.store(pos + 1, memory_order_release);  // Publié vide : pop le saute
+            recovered++;
+        }
+    }
+    if (recovered > 0) {
+        s->published.fetch_add(1, memory_order_seq_cst);
+    }
+    return recovered;
+}
+
+ResultRecord make_result_record(ResultKind kind, const char *video_path, int frame, int pixels) {
+    ResultRecord record;
+    memset(&record, 0, sizeof(record));
+    record.time = -1.0;
+    record.kind = kind;
+    record.pid = getpid();
+    record.frame = frame;
+    record.pixels = pixels;
+    strncpy(record.video, video_path, RESULT_PATH_SIZE - 1);
+    record.video[RESULT_PATH_SIZE - 1] = '\0';
+    return record;
+}
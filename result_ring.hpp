@@ -0,0 +1,78 @@
+#ifndef RESULT_RING_HPP
+#define RESULT_RING_HPP
+
+// File circulaire en mémoire partagée pour remonter les résultats des processus enfants.
+//
+// Le pipe commun recevait du texte libre de tous les enfants : sans découpage en
+// messages, les lignes pouvaient s'entremêler ou arriver coupées. Ici chaque
+// résultat est un enregistrement binaire de taille fixe, déposé dans une file
+// mmap partagée (créée avant fork) sans appel système : l'enfant réserve un
+// emplacement par opération atomique puis le publie. Le parent lit les
+// enregistrements par lots et les reçoit toujours entiers. Un futex ne sert qu'à
+// réveiller le parent quand il attend une file vide (ou un enfant bloqué sur une
+// file pleine).
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define RESULT_PATH_SIZE 208
+
+enum ResultKind {
+    RESULT_NONE = 0,        // Emplacement abandonné par un enfant mort (cf. recover), jamais retourné
+    RESULT_PIXELS = 1,      // Image avec mouvement : pixels = nombre de pixels en mouvement
+    RESULT_VIDEO_DONE = 2,  // Fin de la vidéo : pixels = 1 si un mouvement a été détecté
+    RESULT_QUERY = 3        // Réponse à --query : pixels = 1 si mouvement, frame, time, images décodées
+};
+
+// Enregistrement de résultat (256 octets). Les enfants n'écrivent pas eux-mêmes leurs
+// résultats : seul le parent affiche, dans l'ordre de réception.
+struct ResultRecord {
+    int32_t kind;
+    int32_t pid;      // Processus enfant émetteur
+    int32_t frame;
+    int32_t pixels;
+    double time;              // RESULT_QUERY : horodatage de frame en secondes, -1 sinon
+    int64_t decoded_frames;   // RESULT_QUERY : images décodées pour répondre
+    int64_t total_frames;     // RESULT_QUERY : images du fichier
+    int32_t probes;           // RESULT_QUERY : images clés sondées
+    int32_t reserved;
+    char video[RESULT_PATH_SIZE];  // Chemin de la vidéo (tronqué, terminé par '\0')
+};
+
+class ResultRing {
+public:
+    // capacity : nombre d'enregistrements (arrondi à une puissance de 2)
+    explicit ResultRing(uint32_t capacity = 1024);
+    ~ResultRing();
+    ResultRing(const ResultRing &) = delete;
+    ResultRing &operator=(const ResultRing &) = delete;
+
+    bool is_open() const { return shared_ != nullptr; }
+
+    // Publie un enregistrement (plusieurs producteurs) ; attend si la file est pleine
+    void push(const ResultRecord &record);
+
+    // Retire jusqu'à max enregistrements sans attendre (un seul consommateur)
+    size_t pop(ResultRecord *records, size_t max);
+
+    // Attend qu'un enregistrement soit publié, au plus timeout_ms millisecondes
+    void wait(int timeout_ms);
+
+    // Un enfant mort entre la réservation d'un emplacement et sa publication laisse un trou :
+    // le parent resterait bloqué sur cet emplacement et les autres enfants, la file pleine,
+    // attendraient indéfiniment. À appeler par le parent pour chaque enfant tué (WIFSIGNALED) :
+    // les emplacements réservés par pid, ou réservés mais pas encore revendiqués, sont publiés
+    // vides et sautés par pop. Retourne le nombre d'emplacements repris.
+    int recover(int pid);
+
+private:
+    struct Shared;
+
+    Shared *shared_;
+    size_t size_;
+};
+
+// Remplit un enregistrement pour une vidéo
+ResultRecord make_result_record(ResultKind kind, const char *video_path, int frame, int pixels);
+
+#endif // RESULT_RING_HPP
@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <opencv2/opencv.hpp>
+#include "motion_engine.hpp"
+#include "stream_source.hpp"
+#include "thread_budget.hpp"
+#include "video_reader.hpp"
+
+using namespace cv;
+
+// Détection au fil de l'eau derrière un processus de capture (cf. stream_source.hpp) :
+//   capture | ./stream_detect --input - --raw yuv420p --size 1280x720 --latency-target 20
+//   ./stream_detect --input /tmp/capture.fifo --raw gray --size 640x480
+//   ./stream_detect --input enregistrement.ts --follow 5
+// Une ligne par image en mouvement, écrite aussitôt (sortie vidée à chaque ligne), avec
+// la latence entre l'arrivée de l'image et son résultat.
+
+// Latences mesurées depuis le début du flux
+struct LatencyStats {
+    int64_t frames = 0;
+    int64_t motion_frames = 0;
+    int64_t over_target = 0;
+    int64_t max_backlog = 0;
+    double sum = 0.0;
+    double max = 0.0;
+    double decode_sum = 0.0;  // Fichier vidéo : part de la latence entre le paquet lu et l'image décodée
+};
+
+static void report_frame(const FrameResult &result, int64_t frame, double latency, int64_t backlog,
+                         const StreamOptions &options, LatencyStats &stats) {
+    stats.frames++;
+    stats.sum += latency;
+    if (latency > stats.max) {
+        stats.max = latency;
+    }
+    if (latency > options.latency_target) {
+        stats.over_target++;
+    }
+    if (backlog > stats.max_backlog) {
+        stats.max_backlog = backlog;
+    }
+    if (result.movement_pixels == 0) {
+        return;
+    }
+
+    stats.motion_frames++;
+    printf("image %lld : %d pixels en mouvement, %zu zone(s), latence %.1f ms%s", (long long)frame,
+           result.movement_pixels, result.regions.size(), latency * 1000.0,
+           latency > options.latency_target ? " (au-delà de l'objectif)" : "");
+    if (backlog > 0) {
+        printf(", %lld image(s) en attente", (long long)backlog);
+    }
+    for (size_t i = 0; i < result.regions.size(); i++) {
+        printf(" (%d, %d)", result.regions[i].center.x, result.regions[i].center.y);
+    }
+    printf("\n");
+    fflush(stdout);  // L'alerte ne doit pas attendre le remplissage du tampon de sortie
+}
+
+int main(int argc, char **argv) {
+    StreamOptions options;
+    if (!parse_stream_options(argc, argv, options)) {
+        return 1;
+    }
+    MotionConfig config = parse_motion_config(argc, argv);
+    if (config.sample_every > 1 || config.backend != BACKEND_PIXELS) {
+        fprintf(stderr, "Flux : chaque image est analysée par différence de pixels (--sample et --backend ignorés)\n");
+    }
+
+    // Un seul worker : toutes les ressources vont à OpenCV et au décodeur
+    ThreadBudget budget = parse_thread_budget(argc, argv, 1);
+    apply_thread_budget(budget);
+
+    MotionDetector detector(config);
+    FrameResult result;
+    Mat luma;
+    LatencyStats stats;
+    double start_time = wall_time();
+
+    if (options.raw != RAW_NONE) {
+        RawFrameReader reader;
+        if (!reader.open(options)) {
+            return 1;
+        }
+        while (reader.read_luma(luma)) {
+            detector.process_luma(luma, result);
+            report_frame(result, reader.frame_number(), wall_time() - reader.arrival(), reader.backlog_frames(),
+                         options, stats);
+        }
+    } else {
+        VideoReader reader;
+        if (options.follow > 0) {
+            reader.set_follow(options.follow);
+        }
+        if (!reader.open(options.input)) {
+            fprintf(stderr, "Erreur lors de l'ouverture du flux %s\n", options.input);
+            return 1;
+        }
+        while (reader.read_luma(luma)) {
+            // Latence depuis la lecture du paquet de l'image : démultiplexage, attente du
+            // suivi et délai du décodeur compris
+            stats.decode_sum += wall_time() - reader.arrival();
+            detector.process_luma(luma, result);
+            report_frame(result, reader.frame_number(), wall_time() - reader.arrival(), 0, options, stats);
+        }
+    }
+
+    double elapsed = wall_time() - start_time;
+    printf("Fin du flux : %lld image(s) en %.2f s, %lld en mouvement\n", (long long)stats.frames, elapsed,
+           (long long)stats.motion_frames);
+    if (stats.frames > 0) {
+        printf("Latence arrivée -> résultat : moyenne %.2f ms, max %.2f ms, %lld image(s) au-delà de l'objectif "
+               "de %.1f ms, jusqu'à %lld image(s) en attente\n",
+               stats.sum * 1000.0 / stats.frames, stats.max * 1000.0, (long long)stats.over_target,
+               options.latency_target * 1000.0, (long long)stats.max_backlog);
+        if (options.raw == RAW_NONE) {
+            printf("Dont délai du décodeur (paquet lu -> image décodée) : moyenne %.2f ms\n",
+                   stats.decode_sum * 1000.0 / stats.frames);
+        }
+    }
+    return 0;
+}
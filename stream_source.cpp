@@ -0,0 +1,162 @@
+#include "stream_source.hpp"
+#include "motion_engine.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace cv;
+
+#define FOLLOW_POLL_US 2000            // Attente entre deux essais en fin de fichier suivi
+#define PIPE_BUFFER_SIZE (1 << 20)     // Taille demandée pour un tube (limite : /proc/sys/fs/pipe-max-size)
+
+bool parse_stream_options(int argc, char **argv, StreamOptions &options) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--input") == 0) {
+            options.input = argv[++i];
+        } else if (strcmp(argv[i], "--raw") == 0) {
+            const char *format = argv[++i];
+            if (strcmp(format, "gray") == 0) {
+                options.raw = RAW_GRAY;
+            } else if (strcmp(format, "yuv420p") == 0) {
+                options.raw = RAW_YUV420P;
+            } else {
+                fprintf(stderr, "Format brut inconnu %s (gray ou yuv420p)\n", format);
+                return false;
+            }
+        } else if (strcmp(argv[i], "--size") == 0) {
+            if (!parse_resolution(argv[++i], options.width, options.height)) {
+                fprintf(stderr, "Résolution invalide %s\n", argv[i]);
+                return false;
+            }
+        } else if (strcmp(argv[i], "--follow") == 0) {
+            options.follow = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--latency-target") == 0) {
+            options.latency_target = atof(argv[++i]) / 1000.0;
+        }
+    }
+
+    if (!options.input) {
+        fprintf(stderr, "Source manquante : --input <chemin|->\n");
+        return false;
+    }
+    if (options.raw != RAW_NONE && (options.width <= 0 || options.height <= 0)) {
+        fprintf(stderr, "Les images brutes demandent --size <largeur>x<hauteur>\n");
+        return false;
+    }
+    if (options.raw == RAW_YUV420P && (options.width % 2 || options.height % 2)) {
+        fprintf(stderr, "YUV 4:2:0 : largeur et hauteur paires attendues\n");
+        return false;
+    }
+    if (options.raw == RAW_NONE && strcmp(options.input, "-") == 0) {
+        options.input = "pipe:0";  // Flux conteneur (MPEG-TS...) sur l'entrée standard
+    }
+    return true;
+}
+
+RawFrameReader::RawFrameReader()
+    : fd_(-1), owns_fd_(false), regular_(false), follow_(0.0), width_(0), height_(0), chroma_size_(0), cur_(0),
+      frames_(0), arrival_(0.0) {}
+
+RawFrameReader::~RawFrameReader() {
+    close();
+}
+
+bool RawFrameReader::open(const StreamOptions &options) {
+    close();
+    if (strcmp(options.input, "-") == 0) {
+        fd_ = STDIN_FILENO;
+        owns_fd_ = false;
+    } else {
+        fd_ = ::open(options.input, O_RDONLY | O_CLOEXEC);
+        if (fd_ < 0) {
+            fprintf(stderr, "Impossible d'ouvrir le flux %s : %s\n", options.input, strerror(errno));
+            return false;
+        }
+        owns_fd_ = true;
+    }
+
+    struct stat st;
+    regular_ = fstat(fd_, &st) == 0 && S_ISREG(st.st_mode);
+    follow_ = options.follow;
+    width_ = options.width;
+    height_ = options.height;
+    chroma_size_ = options.raw == RAW_YUV420P ? (size_t)(width_ / 2) * (height_ / 2) * 2 : 0;
+    chroma_.resize(chroma_size_);
+    planes_[0].create(height_, width_, CV_8UC1);
+    planes_[1].create(height_, width_, CV_8UC1);
+    cur_ = 0;
+    frames_ = 0;
+    if (regular_) {
+        posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+    } else if (S_ISFIFO(st.st_mode)) {
+        // Tube agrandi (64 Kio par défaut) : moins de réveils de l'écrivain par image
+        fcntl(fd_, F_SETPIPE_SZ, PIPE_BUFFER_SIZE);
+    }
+    return true;
+}
+
+void RawFrameReader::close() {
+    if (fd_ >= 0 && owns_fd_) {
+        ::close(fd_);
+    }
+    fd_ = -1;
+}
+
+bool RawFrameReader::read_full(unsigned char *dst, size_t size) {
+    double idle_since = -1.0;  // Début de l'attente en fin de fichier suivi
+    while (size > 0) {
+        ssize_t n = read(fd_, dst, size);
+        if (n > 0) {
+            dst += n;
+            size -= (size_t)n;
+            idle_since = -1.0;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n == 0 && regular_ && follow_ > 0) {
+            // Fin provisoire : le fichier est peut-être encore en cours d'écriture
+            double now = wall_time();
+            if (idle_since < 0) {
+                idle_since = now;
+            } else if (now - idle_since >= follow_) {
+                return false;
+            }
+            usleep(FOLLOW_POLL_US);
+        } else {
+            return false;  // Fin du flux (écrivain fermé) ou erreur
+        }
+    }
+    return true;
+}
+
+bool RawFrameReader::read_luma(Mat &luma) {
+    if (fd_ < 0) {
+        return false;
+    }
+    Mat &plane = planes_[cur_];
+    // Plan Y continu (créé par create) : une seule lecture par image
+    if (!read_full(plane.data, (size_t)width_ * height_)) {
+        return false;
+    }
+    if (chroma_size_ > 0 && !read_full(chroma_.data(), chroma_size_)) {
+        return false;
+    }
+    arrival_ = wall_time();
+    frames_++;
+    luma = plane;  // En-tête seulement ; l'autre tampon garde l'image précédente
+    cur_ ^= 1;
+    return true;
+}
+
+int64_t RawFrameReader::backlog_frames() const {
+    int pending = 0;
+    if (fd_ < 0 || regular_ || ioctl(fd_, FIONREAD, &pending) != 0) {
+        return 0;
+    }
+    return pending / (int64_t)((size_t)width_ * height_ + chroma_size_);
+}
@@ -0,0 +1,84 @@
+#ifndef STREAM_SOURCE_HPP
+#define STREAM_SOURCE_HPP
+
+// Sources en flux pour la détection au fil de l'eau.
+//
+// Le détecteur supposait des fichiers complets : il fallait attendre qu'un segment
+// soit fermé pour l'analyser. Deux sources permettent de se placer derrière un
+// processus de capture :
+// - des images brutes (gris 8 bits ou YUV 4:2:0 planaire) de résolution déclarée,
+//   lues sur l'entrée standard, un tube nommé ou un fichier (suivi pendant son
+//   écriture) ; seul le plan Y est gardé, la chrominance est lue puis ignorée ;
+// - un fichier vidéo encore en cours d'écriture, lu par VideoReader en mode suivi
+//   (cf. VideoReader::set_follow ; conteneurs lisibles pendant l'écriture : MPEG-TS,
+//   Matroska, MP4 fragmenté).
+//
+// L'heure d'arrivée de chaque image (dernier octet lu, ou lecture de son paquet par
+// VideoReader, cf. VideoReader::arrival) sert à mesurer la latence arrivée -> résultat. Quand des images
+// attendent déjà dans le tube, la source est en retard sur la capture : ces images
+// sont arrivées plus tôt que la lecture ne peut le voir, retard signalé par
+// backlog_frames().
+
+#include <opencv2/opencv.hpp>
+#include <stdint.h>
+#include <vector>
+
+enum RawFormat {
+    RAW_NONE,     // Pas d'images brutes : fichier vidéo (VideoReader)
+    RAW_GRAY,     // Gris 8 bits, largeur x hauteur octets par image
+    RAW_YUV420P   // YUV 4:2:0 planaire (I420), largeur x hauteur x 3/2 octets par image
+};
+
+struct StreamOptions {
+    const char *input = nullptr;    // Chemin, « - » pour l'entrée standard
+    RawFormat raw = RAW_NONE;
+    int width = 0, height = 0;      // Résolution déclarée des images brutes
+    double follow = 0.0;            // > 0 : suivre un fichier en cours d'écriture (secondes sans croissance avant la fin)
+    double latency_target = 0.05;   // Objectif de latence arrivée -> résultat (secondes)
+};
+
+// Lit --input <chemin|->, --raw gray|yuv420p, --size <largeur>x<hauteur> (ou 720p...),
+// --follow <secondes> et --latency-target <millisecondes> ; false si les options sont incohérentes
+bool parse_stream_options(int argc, char **argv, StreamOptions &options);
+
+// Lecteur d'images brutes de taille fixe
+class RawFrameReader {
+public:
+    RawFrameReader();
+    ~RawFrameReader();
+    RawFrameReader(const RawFrameReader &) = delete;
+    RawFrameReader &operator=(const RawFrameReader &) = delete;
+
+    // path « - » : entrée standard. Un tube nommé bloque jusqu'à l'arrivée d'un écrivain.
+    bool open(const StreamOptions &options);
+    void close();
+
+    // Lit l'image suivante et expose son plan Y (CV_8UC1). Comme VideoReader, deux tampons
+    // alternent : l'image précédente reste valide jusqu'à l'appel suivant (MotionDetector::process_luma).
+    // false en fin de flux (écrivain fermé, ou fichier suivi sans croissance pendant follow secondes).
+    bool read_luma(cv::Mat &luma);
+
+    int64_t frame_number() const { return frames_ - 1; }
+    double arrival() const { return arrival_; }  // wall_time à la fin de la lecture de la dernière image
+
+    // Images complètes déjà en attente dans le tube (0 pour un fichier) : retard sur la capture,
+    // visible seulement dans la limite de la capacité du tube
+    int64_t backlog_frames() const;
+
+private:
+    bool read_full(unsigned char *dst, size_t size);
+
+    int fd_;
+    bool owns_fd_;       // false pour l'entrée standard
+    bool regular_;       // Fichier ordinaire : la fin de fichier peut être provisoire (suivi)
+    double follow_;
+    int width_, height_;
+    size_t chroma_size_;
+    cv::Mat planes_[2];  // Plan Y courant et précédent
+    int cur_;
+    std::vector<unsigned char> chroma_;
+    int64_t frames_;
+    double arrival_;
+};
+
+#endif // STREAM_SOURCE_HPP
@@ -0,0 +1,99 @@
+#include "synthetic_video.hpp"
+#include "motion_engine.hpp"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace cv;
+using namespace std;
+
+SyntheticConfig parse_synthetic_config(int argc, char **argv) {
+    SyntheticConfig config;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--resolution") == 0) {
+            if (!parse_resolution(argv[++i], config.width, config.height)) {
+                fprintf(stderr, "Résolution invalide %s, valeur par défaut utilisée\n", argv[i]);
+            }
+        } else if (strcmp(argv[i], "--fps") == 0) {
+            config.fps = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--frames") == 0) {
+            config.frames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--objects") == 0) {
+            config.objects = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--object-size") == 0) {
+            config.object_size = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--noise") == 0) {
+            config.noise = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0) {
+            config.seed = strtoull(argv[++i], NULL, 10);
+        }
+    }
+    if (config.fps <= 0) {
+        fprintf(stderr, "Fréquence invalide %.2f, valeur par défaut utilisée\n", config.fps);
+        config.fps = SyntheticConfig().fps;
+    }
+    return config;
+}
+
+// Position d'un objet qui rebondit entre 0 et limit (onde triangulaire)
+static double bounce(double position, double limit) {
+    if (limit <= 0) {
+        return 0;
+    }
+    double m = fmod(position, 2 * limit);
+    if (m < 0) {
+        m += 2 * limit;
+    }
+    return m > limit ? 2 * limit - m : m;
+}
+
+SyntheticScene::SyntheticScene(const SyntheticConfig &config) : config_(config) {
+    size_ = config.object_size > 0 ? config.object_size : max(config.height / 10, 4);
+    RNG rng(config.seed);
+
+    // Fond texturé : bruit uniforme basse résolution agrandi (lisse, donc compressible)
+    Mat seed_texture(max(config.height / 32, 2), max(config.width / 32, 2), CV_8UC3);
+    rng.fill(seed_texture, RNG::UNIFORM, 40, 200);
+    resize(seed_texture, background_, Size(config.width, config.height), 0, 0, INTER_LINEAR);
+
+    for (int i = 0; i < config.objects; i++) {
+        Object object;
+        object.x = rng.uniform(0.0, (double)max(config.width - size_, 1));
+        object.y = rng.uniform(0.0, (double)max(config.height - size_, 1));
+        // Vitesse : de 0,2 % à 1 % de la largeur par image, direction quelconque
+        double speed = rng.uniform(0.002, 0.01) * config.width;
+        double angle = rng.uniform(0.0, 2 * CV_PI);
+        object.vx = speed * cos(angle);
+        object.vy = speed * sin(angle);
+        object.color = Scalar(rng.uniform(0, 256), rng.uniform(0, 256), rng.uniform(0, 256));
+        object.disc = (i % 2) == 1;
+        objects_.push_back(object);
+    }
+}
+
+void SyntheticScene::render(int index, Mat &bgr) {
+    background_.copyTo(bgr);
+
+    for (size_t i = 0; i < objects_.size(); i++) {
+        const Object &object = objects_[i];
+        int x = (int)bounce(object.x + object.vx * index, config_.width - size_);
+        int y = (int)bounce(object.y + object.vy * index, config_.height - size_);
+        if (object.disc) {
+            circle(bgr, Point(x + size_ / 2, y + size_ / 2), size_ / 2, object.color, FILLED);
+        } else {
+            rectangle(bgr, Rect(x, y, size_, size_), object.color, FILLED);
+        }
+    }
+
+    if (config_.noise > 0) {
+        // Bruit propre à l'image : graine dérivée de (seed, index), indépendante de l'ordre de rendu
+        RNG rng(config_.seed * 0x9E3779B97F4A7C15ULL + (uint64_t)index + 1);
+        noise_.create(bgr.size(), CV_16SC3);
+        rng.fill(noise_, RNG::NORMAL, 0, config_.noise);
+        bgr.convertTo(work_, CV_16SC3);
+        work_ += noise_;
+        work_.convertTo(bgr, CV_8UC3);  // Saturation à [0, 255]
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef SYNTHETIC_VIDEO_HPP
+#define SYNTHETIC_VIDEO_HPP
+
+// Vidéos synthétiques reproductibles.
+//
+// Une scène est un fond texturé fixe sur lequel se déplacent des objets
+// (rectangles et disques qui rebondissent sur les bords), avec un bruit gaussien
+// facultatif sur chaque image. Tout est déterminé par la configuration et la
+// graine : l'image n est toujours la même, quel que soit l'ordre de rendu. Sert
+// d'entrée aux tests de débit (generate_videos) et aux microbenchmarks (microbench).
+
+#include <opencv2/opencv.hpp>
+#include <stdint.h>
+#include <vector>
+
+struct SyntheticConfig {
+    int width = 1280;
+    int height = 720;
+    double fps = 30.0;
+    int frames = 300;
+    int objects = 3;        // Objets en mouvement (0 : scène statique)
+    int object_size = 0;    // Taille des objets en pixels (0 : height / 10)
+    double noise = 0.0;     // Écart type du bruit gaussien (niveaux de gris)
+    uint64_t seed = 1;
+};
+
+// Lit --resolution, --fps, --frames, --objects, --object-size, --noise et --seed ;
+// les autres paramètres gardent leur valeur par défaut
+SyntheticConfig parse_synthetic_config(int argc, char **argv);
+
+class SyntheticScene {
+public:
+    explicit SyntheticScene(const SyntheticConfig &config);
+
+    // Image index de la scène (BGR, CV_8UC3), tampon réutilisé
+    void render(int index, cv::Mat &bgr);
+
+    const SyntheticConfig &config() const { return config_; }
+
+private:
+    struct Object {
+        double x, y;    // Position initiale (coin haut gauche)
+        double vx, vy;  // Vitesse en pixels par image
+        cv::Scalar color;
+        bool disc;
+    };
+
+    SyntheticConfig config_;
+    int size_;
+    cv::Mat background_;
+    std::vector<Object> objects_;
+    cv::Mat noise_;  // Tampons du bruit (CV_16SC3)
+    cv::Mat work_;
+};
+
+#endif // SYNTHETIC_VIDEO_HPP
@@ -0,0 +1,237 @@
+#include "thread_budget.hpp"
+#include "video_reader.hpp"
+
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <opencv2/opencv.hpp>
+#include <string>
+
+using namespace std;
+
+// Cœurs autorisés par l'affinité du processus (tous les cœurs en ligne si elle est illisible)
+static vector<int> affinity_cpus() {
+    vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int i = 0; i < CPU_SETSIZE; i++) {
+            if (CPU_ISSET(i, &set)) {
+                cpus.push_back(i);
+            }
+        }
+    }
+    if (cpus.empty()) {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        for (long i = 0; i < (n > 0 ? n : 1); i++) {
+            cpus.push_back((int)i);
+        }
+    }
+    return cpus;
+}
+
+// Chemin du cgroup du processus (/proc/self/cgroup) : ligne « 0::<chemin> » en cgroup v2,
+// ligne dont la liste de contrôleurs contient « cpu » en cgroup v1. « / » si introuvable.
+static string own_cgroup_path(bool v2) {
+    string path = "/";
+    FILE *f = fopen("/proc/self/cgroup", "r");
+    if (!f) {
+        return path;
+    }
+    char line[4096];
+    while (fgets(line, sizeof(line), f)) {
+        line[strcspn(line, "\n")] = '\0';
+        char *controllers = strchr(line, ':');
+        char *cgroup = controllers ? strchr(controllers + 1, ':') : NULL;
+        if (!cgroup) {
+            continue;
+        }
+        *cgroup++ = '\0';
+        controllers++;
+        bool match = false;
+        if (v2) {
+            match = strcmp(line, "0") == 0 && controllers[0] == '\0';
+        } else {
+            for (char *name = strtok(controllers, ","); name && !match; name = strtok(NULL, ",")) {
+                match = strcmp(name, "cpu") == 0;
+            }
+        }
+        if (match && cgroup[0] == '/') {
+            path = cgroup;
+            break;
+        }
+    }
+    fclose(f);
+    return path;
+}
+
+// Quota d'un cgroup en cœurs (arrondi au supérieur), 0 si aucun quota. dir : dossier du cgroup.
+static int cgroup_dir_cpu_limit(const string &dir, bool v2) {
+    long long quota = -1, period = 0;
+    if (v2) {
+        // "max 100000" ou "<quota> <période>"
+        FILE *f = fopen((dir + "/cpu.max").c_str(), "r");
+        if (f) {
+            char max[32];
+            if (fscanf(f, "%31s %lld", max, &period) == 2 && strcmp(max, "max") != 0) {
+                quota = atoll(max);
+            }
+            fclose(f);
+        }
+    } else {
+        // quota -1 si aucune limite
+        FILE *f = fopen((dir + "/cpu.cfs_quota_us").c_str(), "r");
+        if (f) {
+            if (fscanf(f, "%lld", &quota) != 1) {
+                quota = -1;
+            }
+            fclose(f);
+        }
+        f = fopen((dir + "/cpu.cfs_period_us").c_str(), "r");
+        if (f) {
+            if (fscanf(f, "%lld", &period) != 1) {
+                period = 0;
+            }
+            fclose(f);
+        }
+    }
+    if (quota <= 0 || period <= 0) {
+        return 0;
+    }
+    return (int)((quota + period - 1) / period);
+}
+
+// Quota CPU du cgroup en nombre de cœurs, 0 si aucun quota. Le cgroup du processus est
+// celui de /proc/self/cgroup (pas la racine de /sys/fs/cgroup, hors conteneur) ; le quota
+// d'un parent s'applique aussi à ses descendants : le plus petit est retenu.
+static int cgroup_cpu_limit() {
+    bool v2 = access("/sys/fs/cgroup/cgroup.controllers", F_OK) == 0;
+    string root = v2 ? "/sys/fs/cgroup" : "/sys/fs/cgroup/cpu";
+    string path = own_cgroup_path(v2);
+
+    int limit = 0;
+    for (;;) {
+        int quota = cgroup_dir_cpu_limit(root + (path == "/" ? "" : path), v2);
+        if (quota > 0 && (limit == 0 || quota < limit)) {
+            limit = quota;
+        }
+        if (path == "/") {
+            break;
+        }
+        size_t slash = path.rfind('/');
+        path = slash == 0 ? "/" : path.substr(0, slash);
+    }
+    return limit;
+}
+
+int available_cpus() {
+    int cpus = (int)affinity_cpus().size();
+    int limit = cgroup_cpu_limit();
+    if (limit > 0 && limit < cpus) {
+        cpus = limit;
+    }
+    return cpus > 0 ? cpus : 1;
+}
+
+// Part de chaque worker (au moins un cœur)
+static int worker_share(const ThreadBudget &budget) {
+    int share = budget.cpus / budget.workers;
+    return share > 1 ? share : 1;
+}
+
+// Pool OpenCV d'un processus : un seul de ses workers s'en sert à la fois (les autres
+// exécutent leur parallel_for_ dans leur propre thread), il reçoit donc les cœurs que
+// les workers du processus n'occupent pas, plus le thread appelant
+static int process_opencv_threads(const ThreadBudget &budget) {
+    int threads = (worker_share(budget) - 1) * budget.process_workers + 1;
+    return threads < budget.cpus ? threads : budget.cpus;
+}
+
+ThreadBudget plan_thread_budget(int workers, int tasks, int process_workers) {
+    ThreadBudget budget;
+    budget.cpu_list = affinity_cpus();
+    budget.cpus = available_cpus();
+
+    budget.workers = workers > 0 ? workers : budget.cpus;
+    if (tasks > 0 && budget.workers > tasks) {
+        budget.workers = tasks;
+    }
+
+    budget.process_workers =
+        process_workers > 0 && process_workers < budget.workers ? process_workers : budget.workers;
+    budget.decoder_threads = worker_share(budget);
+    budget.opencv_threads = process_opencv_threads(budget);
+    return budget;
+}
+
+void set_process_workers(ThreadBudget &budget, int process_workers) {
+    budget.process_workers = process_workers > 0 ? process_workers : 1;
+    if (!budget.opencv_fixed) {
+        budget.opencv_threads = process_opencv_threads(budget);
+    }
+}
+
+ThreadBudget parse_thread_budget(int argc, char **argv, int tasks, int default_workers, int process_workers) {
+    int workers = default_workers, opencv_threads = 0, decoder_threads = 0;
+    bool pin = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--pin") == 0) {
+            pin = true;
+        } else if (i + 1 < argc && strcmp(argv[i], "--workers") == 0) {
+            workers = atoi(argv[++i]);
+        } else if (i + 1 < argc && strcmp(argv[i], "--cv-threads") == 0) {
+            opencv_threads = atoi(argv[++i]);
+        } else if (i + 1 < argc && strcmp(argv[i], "--decoder-threads") == 0) {
+            decoder_threads = atoi(argv[++i]);
+        }
+    }
+
+    ThreadBudget budget = plan_thread_budget(workers, tasks, process_workers);
+    if (opencv_threads > 0) {
+        budget.opencv_threads = opencv_threads;
+        budget.opencv_fixed = true;
+    }
+    if (decoder_threads > 0) {
+        budget.decoder_threads = decoder_threads;
+    }
+    budget.pin = pin;
+    return budget;
+}
+
+void apply_thread_budget(const ThreadBudget &budget) {
+    cv::setNumThreads(budget.opencv_threads);
+    VideoReader::set_default_threads(budget.decoder_threads);
+}
+
+void pin_worker(const ThreadBudget &budget, int worker) {
+    if (!budget.pin || budget.cpu_list.empty()) {
+        return;
+    }
+
+    // Part du worker : cœurs consécutifs de la liste autorisée (en boucle s'il y a plus
+    // de workers que de cœurs)
+    int n = (int)budget.cpu_list.size();
+    int share = worker_share(budget);
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int i = 0; i < share; i++) {
+        CPU_SET(budget.cpu_list[(worker * share + i) % n], &set);
+    }
+    // pid 0 : le thread appelant seulement ; les threads créés ensuite héritent de l'affinité
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+        perror("Erreur lors de l'épinglage du worker");
+    }
+}
+
+void pin_pool_worker(int index, void *arg) {
+    const ThreadBudget *budget = (const ThreadBudget *)arg;
+    pin_worker(*budget, budget->first_worker + index);
+}
+
+void print_thread_budget(const ThreadBudget &budget) {
+    printf("Budget de threads : %d cœur(s), %d worker(s) x décodeur %d, OpenCV %d par processus (%d worker(s))%s\n",
+           budget.cpus, budget.workers, budget.decoder_threads, budget.opencv_threads, budget.process_workers,
+           budget.pin ? ", workers épinglés" : "");
+}
@@ -0,0 +1,65 @@
+#ifndef THREAD_BUDGET_HPP
+#define THREAD_BUDGET_HPP
+
+// Budget de threads global.
+//
+// Les workers externes (processus ou threads), le parallel_for_ d'OpenCV et les
+// threads de décodage de FFmpeg supposent chacun disposer de tous les cœurs :
+// sans budget, on obtient workers x threads OpenCV x threads décodeur threads
+// actifs. Le budget part des cœurs réellement disponibles (affinité du
+// processus et quota CPU du cgroup) et les partage : chaque worker reçoit une
+// part égale, utilisée par ses threads de décodage. Le pool d'OpenCV, lui, est
+// global au processus (cv::setNumThreads) et partagé par tous ses workers ; un
+// parallel_for_ lancé pendant qu'un autre occupe le pool s'exécute dans le thread
+// appelant. Le pool reçoit donc les cœurs du processus que ses workers n'occupent
+// pas déjà, plus le thread appelant. Les workers peuvent être épinglés chacun sur
+// sa part des cœurs.
+
+#include <vector>
+
+struct ThreadBudget {
+    int cpus = 1;              // Cœurs disponibles
+    int workers = 1;           // Workers externes (processus ou threads)
+    int process_workers = 1;   // Workers de chaque processus (au plus)
+    int opencv_threads = 1;    // Pool OpenCV de chaque processus (cv::setNumThreads, global au processus)
+    bool opencv_fixed = false; // opencv_threads imposé par --cv-threads
+    int decoder_threads = 1;   // Threads de décodage de chaque lecteur
+    bool pin = false;          // Épingler chaque worker sur sa part des cœurs
+    int first_worker = 0;      // Indice du premier worker de ce processus (pin_pool_worker)
+    std::vector<int> cpu_list; // Cœurs autorisés par l'affinité du processus
+};
+
+// Cœurs utilisables par le processus : cœurs de son affinité, limités par le quota
+// CPU du cgroup (cgroup v2 cpu.max ou v1 cpu.cfs_quota_us, arrondi au supérieur)
+int available_cpus();
+
+// Partage les cœurs disponibles. workers <= 0 : un worker par cœur ; tasks > 0 :
+// pas plus de workers que de tâches (les cœurs en trop vont aux threads internes).
+// process_workers : workers par processus (<= 0 : tous les workers sont des threads
+// du processus courant), d'où la taille du pool OpenCV de chaque processus.
+ThreadBudget plan_thread_budget(int workers, int tasks, int process_workers = 0);
+
+// plan_thread_budget avec --workers <n> (default_workers sans cette option), puis
+// --cv-threads <n> (pool OpenCV de chaque processus), --decoder-threads <n> (threads
+// de décodage de chaque lecteur) et --pin (épinglage des workers)
+ThreadBudget parse_thread_budget(int argc, char **argv, int tasks, int default_workers = 0, int process_workers = 0);
+
+// Change le nombre de workers du processus (répartition décidée après le plan) et
+// recalcule son pool OpenCV, sauf s'il est imposé par --cv-threads
+void set_process_workers(ThreadBudget &budget, int process_workers);
+
+// Applique au processus courant les réglages communs à tous ses workers
+// (cv::setNumThreads, threads de décodage des VideoReader ouverts ensuite)
+void apply_thread_budget(const ThreadBudget &budget);
+
+// Épingle le thread appelant (et les threads qu'il créera) sur la part du worker
+// d'indice worker ; sans effet si budget.pin est faux
+void pin_worker(const ThreadBudget &budget, int worker);
+
+// Initialisation des workers d'un ThreadPool (ThreadPool::init_fn) : arg est le ThreadBudget
+void pin_pool_worker(int index, void *arg);
+
+// Affiche le budget (cœurs, workers, threads décodeur, pool OpenCV, épinglage)
+void print_thread_budget(const ThreadBudget &budget);
+
+#endif // THREAD_BUDGET_HPP
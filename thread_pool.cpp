@@ -0,0 +1,163 @@
+#include "thread_pool.hpp"
+#include "thread_budget.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Indice du worker courant (-1 hors du pool)
+static thread_local int current_worker = -1;
+static thread_local ThreadPool *current_pool = nullptr;
+
+int ThreadPool::hardware_threads() {
+    return available_cpus();
+}
+
+ThreadPool::ThreadPool(int num_threads, init_fn init, void *init_arg)
+    : init_(init), init_arg_(init_arg), queued_(0), unfinished_(0), next_(0), stop_(false) {
+    if (num_threads <= 0) {
+        num_threads = hardware_threads();
+    }
+    pthread_mutex_init(&lock_, NULL);
+    pthread_cond_init(&work_cond_, NULL);
+    pthread_cond_init(&done_cond_, NULL);
+
+    for (int i = 0; i < num_threads; i++) {
+        Worker *worker = new Worker;
+        worker->pool = this;
+        worker->index = i;
+        pthread_mutex_init(&worker->lock, NULL);
+        workers_.push_back(worker);
+    }
+    // Démarrer les threads une fois toutes les files créées (les voleurs les parcourent)
+    int started = 0;
+    for (size_t i = 0; i < workers_.size(); i++) {
+        int err = pthread_create(&workers_[i]->thread, NULL, worker_main, workers_[i]);
+        workers_[i]->started = err == 0;
+        if (err != 0) {
+            fprintf(stderr, "Erreur lors de la création du thread : %s\n", strerror(err));
+        } else {
+            started++;
+        }
+    }
+    if (started == 0) {
+        fprintf(stderr, "Aucun thread du pool n'a pu être créé\n");
+        exit(1);  // Les tâches ne seraient jamais exécutées : wait() bloquerait
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    wait();
+
+    pthread_mutex_lock(&lock_);
+    stop_ = true;
+    pthread_cond_broadcast(&work_cond_);
+    pthread_mutex_unlock(&lock_);
+
+    // Tous les threads doivent être arrêtés avant de libérer les files qu'ils peuvent voler
+    for (size_t i = 0; i < workers_.size(); i++) {
+        if (workers_[i]->started) {
+            pthread_join(workers_[i]->thread, NULL);
+        }
+    }
+    for (size_t i = 0; i < workers_.size(); i++) {
+        pthread_mutex_destroy(&workers_[i]->lock);
+        delete workers_[i];
+    }
+    pthread_cond_destroy(&done_cond_);
+    pthread_cond_destroy(&work_cond_);
+    pthread_mutex_destroy(&lock_);
+}
+
+void ThreadPool::submit(job_fn fn, void *arg) {
+    pthread_mutex_lock(&lock_);
+    queued_++;
+    unfinished_++;
+    int index = (current_pool == this) ? current_worker : (int)(next_++ % workers_.size());
+    pthread_mutex_unlock(&lock_);
+
+    Worker *worker = workers_[index];
+    pthread_mutex_lock(&worker->lock);
+    worker->jobs.push_back(Job{fn, arg});
+    pthread_mutex_unlock(&worker->lock);
+
+    pthread_mutex_lock(&lock_);
+    pthread_cond_signal(&work_cond_);
+    pthread_mutex_unlock(&lock_);
+}
+
+void ThreadPool::wait() {
+    pthread_mutex_lock(&lock_);
+    while (unfinished_ > 0) {
+        pthread_cond_wait(&done_cond_, &lock_);
+    }
+    pthread_mutex_unlock(&lock_);
+}
+
+bool ThreadPool::take_job(int index, Job &job) {
+    // Sa propre file d'abord, par l'arrière (tâche la plus récente)
+    Worker *self = workers_[index];
+    pthread_mutex_lock(&self->lock);
+    if (!self->jobs.empty()) {
+        job = self->jobs.back();
+        self->jobs.pop_back();
+        pthread_mutex_unlock(&self->lock);
+        return true;
+    }
+    pthread_mutex_unlock(&self->lock);
+
+    // Sinon voler la tâche la plus ancienne d'un autre worker
+    size_t n = workers_.size();
+    for (size_t k = 1; k < n; k++) {
+        Worker *victim = workers_[(index + k) % n];
+        pthread_mutex_lock(&victim->lock);
+        if (!victim->jobs.empty()) {
+            job = victim->jobs.front();
+            victim->jobs.pop_front();
+            pthread_mutex_unlock(&victim->lock);
+            return true;
+        }
+        pthread_mutex_unlock(&victim->lock);
+    }
+    return false;
+}
+
+void *ThreadPool::worker_main(void *arg) {
+    Worker *worker = (Worker *)arg;
+    ThreadPool *pool = worker->pool;
+    current_pool = pool;
+    current_worker = worker->index;
+    if (pool->init_) {
+        pool->init_(worker->index, pool->init_arg_);
+    }
+
+    for (;;) {
+        Job job;
+        if (pool->take_job(worker->index, job)) {
+            pthread_mutex_lock(&pool->lock_);
+            pool->queued_--;
+            pthread_mutex_unlock(&pool->lock_);
+
+            job.fn(job.arg);
+
+            pthread_mutex_lock(&pool->lock_);
+            if (--pool->unfinished_ == 0) {
+                pthread_cond_broadcast(&pool->done_cond_);
+            }
+            pthread_mutex_unlock(&pool->lock_);
+            continue;
+        }
+
+        // Aucune tâche visible : dormir jusqu'à la prochaine soumission
+        pthread_mutex_lock(&pool->lock_);
+        while (pool->queued_ == 0 && !pool->stop_) {
+            pthread_cond_wait(&pool->work_cond_, &pool->lock_);
+        }
+        bool stop = pool->stop_ && pool->queued_ == 0;
+        pthread_mutex_unlock(&pool->lock_);
+        if (stop) {
+            break;
+        }
+    }
+    return NULL;
+}
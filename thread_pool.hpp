@@ -0,0 +1,68 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+// Pool de threads de taille fixe avec vol de tâches.
+//
+// Chaque worker possède sa propre file (deque) : il dépile ses tâches par
+// l'arrière et, quand elle est vide, vole les tâches les plus anciennes à
+// l'avant de la file des autres workers. Le nombre de threads ne dépend donc
+// plus du nombre de vidéos.
+
+#include <pthread.h>
+#include <deque>
+#include <vector>
+
+class ThreadPool {
+public:
+    typedef void *(*job_fn)(void *);
+    // Appelée par chaque worker à son démarrage, avant toute tâche (épinglage, cf. thread_budget.hpp)
+    typedef void (*init_fn)(int index, void *arg);
+
+    // num_threads <= 0 : un thread par cœur disponible
+    explicit ThreadPool(int num_threads = 0, init_fn init = nullptr, void *init_arg = nullptr);
+    ~ThreadPool();  // Attend la fin des tâches puis arrête les workers
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // Ajoute une tâche fn(arg) ; depuis un worker, elle va dans sa propre file
+    void submit(job_fn fn, void *arg);
+
+    // Attend la fin de toutes les tâches soumises
+    void wait();
+
+    int size() const { return (int)workers_.size(); }
+
+    // Nombre de cœurs disponibles pour le processus (affinité et quota cgroup, cf. available_cpus)
+    static int hardware_threads();
+
+private:
+    struct Job {
+        job_fn fn;
+        void *arg;
+    };
+
+    struct Worker {
+        ThreadPool *pool;
+        int index;
+        pthread_t thread;
+        bool started;  // false si pthread_create a échoué : rien à joindre, sa file est vidée par les voleurs
+        pthread_mutex_t lock;
+        std::deque<Job> jobs;
+    };
+
+    static void *worker_main(void *arg);
+    bool take_job(int index, Job &job);
+
+    std::vector<Worker *> workers_;
+    init_fn init_;
+    void *init_arg_;
+    pthread_mutex_t lock_;
+    pthread_cond_t work_cond_;  // Nouvelle tâche ou arrêt
+    pthread_cond_t done_cond_;  // Toutes les tâches terminées
+    int queued_;                // Tâches en attente dans les files
+    int unfinished_;            // Tâches soumises et pas encore terminées
+    unsigned next_;             // Répartition des soumissions externes
+    bool stop_;
+};
+
+#endif // THREAD_POOL_HPP
@@ -0,0 +1,231 @@
+#include "video_io.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+static IoMode g_io_mode = IO_DEFAULT;
+static size_t g_io_readahead = IO_DEFAULT_READAHEAD;
+static bool g_io_stats = false;
+
+// Même horloge que wall_time() (motion_engine), sans dépendre du moteur de détection
+static double monotonic_time() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+void set_default_io(IoMode mode, size_t readahead) {
+    g_io_mode = mode;
+    g_io_readahead = readahead > 0 ? readahead : IO_DEFAULT_READAHEAD;
+}
+
+IoMode default_io_mode() {
+    return g_io_mode;
+}
+
+size_t default_io_readahead() {
+    return g_io_readahead;
+}
+
+void io_stats_enable() {
+    g_io_stats = true;
+}
+
+bool io_stats_enabled() {
+    return g_io_stats;
+}
+
+VideoInput::VideoInput()
+    : fd_(-1), mode_(IO_READ), map_(nullptr), size_(0), pos_(0), advised_(0), readahead_(IO_DEFAULT_READAHEAD) {}
+
+VideoInput::~VideoInput() {
+    close();
+}
+
+bool VideoInput::open(const char *path, IoMode mode, size_t readahead) {
+    close();
+    fd_ = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd_ < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd_, &st) != 0) {
+        close();
+        return false;
+    }
+    mode_ = mode;
+    size_ = st.st_size;
+    pos_ = 0;
+    advised_ = 0;
+    readahead_ = readahead;
+    stats_ = IoStats();
+
+    if (mode_ == IO_MMAP && size_ > 0) {
+        void *map = mmap(NULL, (size_t)size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+        if (map == MAP_FAILED) {
+            mode_ = IO_READ;  // Projection impossible (système de fichiers, taille) : lectures alignées
+        } else {
+            map_ = (const uint8_t *)map;
+            madvise(map, (size_t)size_, MADV_SEQUENTIAL);  // Pages lues libérées plus tôt, lecture anticipée agressive
+        }
+    }
+    if (mode_ == IO_READ) {
+        posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);  // Double la fenêtre de lecture anticipée du noyau
+    }
+    advise(0);
+    return true;
+}
+
+void VideoInput::close() {
+    if (map_) {
+        munmap((void *)map_, (size_t)size_);
+        map_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+// Annonce au noyau la fenêtre qui suit pos dès que la lecture entre dans sa seconde moitié :
+// une grande requête par fenêtre plutôt que des lectures anticipées au fil des blocs
+void VideoInput::advise(int64_t pos) {
+    if (pos + (int64_t)readahead_ / 2 < advised_ || advised_ >= size_) {
+        return;
+    }
+    int64_t start = pos > advised_ ? pos : advised_;
+    int64_t length = pos + (int64_t)readahead_ - start;
+    if (start + length > size_) {
+        length = size_ - start;
+    }
+    if (length <= 0) {
+        return;
+    }
+    if (map_) {
+        const long page = sysconf(_SC_PAGESIZE);
+        int64_t aligned = start & ~(int64_t)(page - 1);  // madvise veut une adresse alignée sur la page
+        madvise((void *)(map_ + aligned), (size_t)(start + length - aligned), MADV_WILLNEED);
+    } else {
+        posix_fadvise(fd_, start, length, POSIX_FADV_WILLNEED);
+    }
+    advised_ = start + length;
+}
+
+int VideoInput::read_packet(void *opaque, uint8_t *buf, int buf_size) {
+    VideoInput *input = (VideoInput *)opaque;
+    if (input->pos_ >= input->size_) {
+        return AVERROR_EOF;
+    }
+    // Lectures alignées sur IO_CHUNK_SIZE : après un déplacement, lire jusqu'à la frontière suivante
+    int64_t size = IO_CHUNK_SIZE - input->pos_ % IO_CHUNK_SIZE;
+    if (size > buf_size) {
+        size = buf_size;
+    }
+    if (size > input->size_ - input->pos_) {
+        size = input->size_ - input->pos_;
+    }
+    input->advise(input->pos_);
+
+    double start = monotonic_time();
+    ssize_t n;
+    if (input->map_) {
+        memcpy(buf, input->map_ + input->pos_, (size_t)size);  // Défauts de page : attente du disque
+        n = (ssize_t)size;
+    } else {
+        do {
+            n = pread(input->fd_, buf, (size_t)size, input->pos_);
+        } while (n < 0 && errno == EINTR);
+    }
+    input->stats_.io_wait += monotonic_time() - start;
+    if (n < 0) {
+        return AVERROR(errno);
+    }
+    if (n == 0) {
+        return AVERROR_EOF;
+    }
+    input->pos_ += n;
+    input->stats_.bytes_read += n;
+    input->stats_.requests++;
+    return (int)n;
+}
+
+int64_t VideoInput::seek(void *opaque, int64_t offset, int whence) {
+    VideoInput *input = (VideoInput *)opaque;
+    if (whence & AVSEEK_SIZE) {
+        return input->size_;
+    }
+    int64_t pos;
+    switch (whence & ~AVSEEK_FORCE) {
+    case SEEK_SET:
+        pos = offset;
+        break;
+    case SEEK_CUR:
+        pos = input->pos_ + offset;
+        break;
+    case SEEK_END:
+        pos = input->size_ + offset;
+        break;
+    default:
+        return AVERROR(EINVAL);
+    }
+    if (pos < 0) {
+        return AVERROR(EINVAL);
+    }
+    if (pos != input->pos_) {
+        input->stats_.seeks++;
+        input->advised_ = pos;  // Nouvelle fenêtre à partir de la position atteinte
+    }
+    input->pos_ = pos;
+    return pos;
+}
+
+void parse_io_options(int argc, char **argv) {
+    IoMode mode = IO_DEFAULT;
+    size_t readahead = IO_DEFAULT_READAHEAD;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--io") == 0 && i + 1 < argc) {
+            const char *name = argv[++i];
+            if (strcmp(name, "read") == 0) {
+                mode = IO_READ;
+            } else if (strcmp(name, "mmap") == 0) {
+                mode = IO_MMAP;
+            } else if (strcmp(name, "ffmpeg") != 0) {
+                fprintf(stderr, "Mode d'entrée inconnu %s (ffmpeg, read ou mmap)\n", name);
+            }
+        } else if (strcmp(argv[i], "--io-readahead") == 0 && i + 1 < argc) {
+            const char *value = argv[++i];
+            char *end;
+            errno = 0;
+            long long mib = strtoll(value, &end, 10);
+            if (end == value || *end != '\0' || errno == ERANGE || mib < 0 || mib > (long long)(SIZE_MAX >> 20)) {
+                fprintf(stderr, "Fenêtre de lecture anticipée invalide %s, valeur par défaut utilisée\n", value);
+            } else {
+                readahead = (size_t)mib << 20;
+            }
+        } else if (strcmp(argv[i], "--io-stats") == 0) {
+            io_stats_enable();
+        }
+    }
+    if (io_stats_enabled() && mode == IO_DEFAULT) {
+        mode = IO_READ;
+    }
+    set_default_io(mode, readahead);
+}
+
+void print_io_stats(const char *video_path, const IoStats &stats, double elapsed) {
+    double part = elapsed > 0 ? 100.0 * stats.io_wait / elapsed : 0.0;
+    printf("%s : %.1f Mio lus en %lld lecture(s), %lld déplacement(s), attente E/S %.3f s (%.1f %% du traitement)\n",
+           video_path, stats.bytes_read / (1024.0 * 1024.0), (long long)stats.requests, (long long)stats.seeks,
+           stats.io_wait, part);
+}
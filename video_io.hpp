@@ -0,0 +1,82 @@
+#ifndef VIDEO_IO_HPP
+#define VIDEO_IO_HPP
+
+// Entrée des fichiers vidéo pour le démultiplexeur (contexte AVIO personnalisé).
+//
+// Le protocole file de FFmpeg lit par petits blocs (32 Kio) avec la lecture
+// anticipée par défaut du noyau. Quand beaucoup de workers lisent de gros fichiers
+// en même temps sur un disque à plateaux, les lectures s'entrelacent et la tête
+// saute d'un fichier à l'autre. Ici chaque fichier est lu en gros blocs alignés
+// (IO_CHUNK_SIZE) avec une fenêtre de lecture anticipée annoncée au noyau
+// (posix_fadvise WILLNEED, ou madvise pour un fichier projeté en mémoire) : chaque
+// worker fait moins de requêtes, plus longues et séquentielles.
+//
+// Les octets lus et le temps passé à attendre les données (appels read, ou copies
+// depuis la projection, défauts de page compris) sont comptés par fichier.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define IO_CHUNK_SIZE (1 << 20)              // Taille des lectures (et du tampon AVIO)
+#define IO_DEFAULT_READAHEAD (8 << 20)       // Fenêtre de lecture anticipée par défaut
+
+enum IoMode {
+    IO_DEFAULT,  // Protocole file de FFmpeg
+    IO_READ,     // Lectures alignées de IO_CHUNK_SIZE octets, posix_fadvise SEQUENTIAL + WILLNEED
+    IO_MMAP      // Fichier projeté en mémoire, madvise SEQUENTIAL + WILLNEED
+};
+
+struct IoStats {
+    int64_t bytes_read = 0;   // Octets transmis au démultiplexeur
+    int64_t requests = 0;     // Lectures (ou copies depuis la projection)
+    int64_t seeks = 0;        // Déplacements demandés par le démultiplexeur
+    double io_wait = 0.0;     // Secondes passées à attendre les données
+};
+
+class VideoInput {
+public:
+    VideoInput();
+    ~VideoInput();
+    VideoInput(const VideoInput &) = delete;
+    VideoInput &operator=(const VideoInput &) = delete;
+
+    // mode IO_READ ou IO_MMAP ; readahead : octets annoncés au noyau en avance de la lecture
+    bool open(const char *path, IoMode mode, size_t readahead);
+    void close();
+
+    // Rappels du contexte AVIO (opaque = VideoInput*) : lecture et déplacement (AVSEEK_SIZE compris)
+    static int read_packet(void *opaque, uint8_t *buf, int buf_size);
+    static int64_t seek(void *opaque, int64_t offset, int whence);
+
+    const IoStats &stats() const { return stats_; }
+
+private:
+    void advise(int64_t pos);
+
+    int fd_;
+    IoMode mode_;
+    const uint8_t *map_;  // Projection du fichier (IO_MMAP)
+    int64_t size_;
+    int64_t pos_;
+    int64_t advised_;     // Fin de la zone déjà annoncée au noyau
+    size_t readahead_;
+    IoStats stats_;
+};
+
+// Mode et fenêtre de lecture anticipée des VideoReader ouverts ensuite (--io read|mmap, --io-readahead <Mio>)
+void set_default_io(IoMode mode, size_t readahead);
+IoMode default_io_mode();
+size_t default_io_readahead();
+
+// --io-stats : octets lus et attente des entrées/sorties affichés à la fin de chaque vidéo
+void io_stats_enable();
+bool io_stats_enabled();
+
+// Lit --io read|mmap, --io-readahead <Mio> et --io-stats (qui demande au moins IO_READ :
+// le protocole file de FFmpeg ne compte pas ses lectures)
+void parse_io_options(int argc, char **argv);
+
+// Affiche les statistiques d'entrée d'une vidéo (durée : temps de traitement de la vidéo)
+void print_io_stats(const char *video_path, const IoStats &stats, double elapsed);
+
+#endif // VIDEO_IO_HPP
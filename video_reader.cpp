@@ -0,0 +1,395 @@
+#include "video_reader.hpp"
+
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/motion_vector.h>
+#include <libavutil/pixdesc.h>
+#include <libswscale/swscale.h>
+}
+
+using namespace cv;
+
+// Le plan 0 est-il une luminance 8 bits utilisable telle quelle ? (YUV planaire, NV12, GRAY8)
+static bool luma_plane_usable(int format) {
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get((AVPixelFormat)format);
+    if (!desc || (desc->flags & (AV_PIX_FMT_FLAG_RGB | AV_PIX_FMT_FLAG_PAL | AV_PIX_FMT_FLAG_HWACCEL))) {
+        return false;
+    }
+    const AVComponentDescriptor &y = desc->comp[0];
+    return y.plane == 0 && y.step == 1 && y.offset == 0 && y.shift == 0 && y.depth == 8;
+}
+
+// Même horloge que wall_time() (motion_engine), sans dépendre du moteur de détection
+static double monotonic_time() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+int VideoReader::default_threads_ = 0;
+
+void VideoReader::set_default_threads(int threads) {
+    default_threads_ = threads > 0 ? threads : 0;
+}
+
+VideoReader::VideoReader()
+    : fmt_(nullptr), avio_(nullptr), input_(nullptr), dec_(nullptr), pkt_(nullptr), grabbed_(nullptr), cur_(0), decoded_(0), stream_(-1), draining_(false),
+      export_mvs_(false), follow_timeout_(0.0), sws_gray_(nullptr), sws_bgr_(nullptr), next_arrival_(0),
+      last_packet_time_(0.0), arrival_(0.0) {
+    frames_[0] = frames_[1] = nullptr;
+    forget_arrivals();
+}
+
+VideoReader::~VideoReader() {
+    close();
+}
+
+bool VideoReader::open(const char *path) {
+    close();
+
+    AVDictionary *options = NULL;
+    if (follow_timeout_ > 0) {
+        char timeout[32];
+        snprintf(timeout, sizeof(timeout), "%lld", (long long)(follow_timeout_ * 1e6));
+        av_dict_set(&options, "follow", "1", 0);
+        av_dict_set(&options, "rw_timeout", timeout, 0);  // Microsecondes sans nouvelles données
+    }
+    if (default_io_mode() != IO_DEFAULT && follow_timeout_ <= 0) {
+        // Lectures alignées ou projection en mémoire (cf. video_io.hpp). Si path n'est pas un
+        // fichier ordinaire lisible (pipe:0...), le protocole de FFmpeg est gardé.
+        input_ = new VideoInput();
+        if (input_->open(path, default_io_mode(), default_io_readahead())) {
+            unsigned char *buffer = (unsigned char *)av_malloc(IO_CHUNK_SIZE);
+            avio_ = buffer ? avio_alloc_context(buffer, IO_CHUNK_SIZE, 0, input_, VideoInput::read_packet, NULL,
+                                                VideoInput::seek)
+                           : nullptr;
+            if (!avio_) {
+                av_free(buffer);
+                close();
+                return false;
+            }
+            fmt_ = avformat_alloc_context();
+            if (!fmt_) {
+                close();
+                return false;
+            }
+            fmt_->pb = avio_;
+            fmt_->flags |= AVFMT_FLAG_CUSTOM_IO;
+        } else {
+            delete input_;
+            input_ = nullptr;
+        }
+    }
+
+    int opened = avformat_open_input(&fmt_, path, NULL, &options);
+    av_dict_free(&options);
+    if (opened < 0) {
+        fmt_ = nullptr;  // Libéré par avformat_open_input (pas le contexte AVIO personnalisé)
+        close();
+        return false;
+    }
+    if (avformat_find_stream_info(fmt_, NULL) < 0) {
+        close();
+        return false;
+    }
+
+    stream_ = av_find_best_stream(fmt_, AVMEDIA_TYPE_VIDEO, -1, -1, NULL, 0);
+    if (stream_ < 0) {
+        close();
+        return false;
+    }
+
+    const AVCodecParameters *par = fmt_->streams[stream_]->codecpar;
+    const AVCodec *codec = avcodec_find_decoder(par->codec_id);
+    dec_ = codec ? avcodec_alloc_context3(codec) : nullptr;
+    if (!dec_ || avcodec_parameters_to_context(dec_, par) < 0) {
+        close();
+        return false;
+    }
+    dec_->thread_count = default_threads_;  // 0 : nombre de threads de décodage choisi par FFmpeg
+    if (follow_timeout_ > 0) {
+        dec_->flags |= AV_CODEC_FLAG_LOW_DELAY;
+        dec_->thread_type = FF_THREAD_SLICE;  // Threads par tranche : aucune image retenue
+    }
+    if (export_mvs_) {
+        // Le déblocage reste complet : les images décodées servent de référence aux suivantes,
+        // et le repli sur les images intra compare l'image clé à la précédente, pixel à pixel
+        dec_->flags2 |= AV_CODEC_FLAG2_EXPORT_MVS;
+    }
+    if (avcodec_open2(dec_, codec, NULL) < 0) {
+        close();
+        return false;
+    }
+
+    // Ne lire que le flux vidéo
+    for (unsigned i = 0; i < fmt_->nb_streams; i++) {
+        if ((int)i != stream_) {
+            fmt_->streams[i]->discard = AVDISCARD_ALL;
+        }
+    }
+
+    pkt_ = av_packet_alloc();
+    frames_[0] = av_frame_alloc();
+    frames_[1] = av_frame_alloc();
+    grabbed_ = av_frame_alloc();
+    cur_ = 0;
+    decoded_ = 0;
+    draining_ = false;
+    forget_arrivals();
+    return true;
+}
+
+void VideoReader::close() {
+    av_frame_free(&frames_[0]);
+    av_frame_free(&frames_[1]);
+    av_frame_free(&grabbed_);
+    av_packet_free(&pkt_);
+    avcodec_free_context(&dec_);
+    if (fmt_) {
+        avformat_close_input(&fmt_);
+    }
+    if (avio_) {
+        av_freep(&avio_->buffer);  // Tampon éventuellement réalloué par FFmpeg : celui du contexte
+        avio_context_free(&avio_);
+    }
+    delete input_;
+    input_ = nullptr;
+    sws_freeContext(sws_gray_);
+    sws_freeContext(sws_bgr_);
+    sws_gray_ = sws_bgr_ = nullptr;
+    gray_[0].release();
+    gray_[1].release();
+    stream_ = -1;
+}
+
+void VideoReader::forget_arrivals() {
+    for (int i = 0; i < VIDEO_ARRIVAL_SLOTS; i++) {
+        arrivals_[i].pts = AV_NOPTS_VALUE;
+    }
+    next_arrival_ = 0;
+}
+
+bool VideoReader::decode_next(AVFrame *frame, double *arrival) {
+    for (;;) {
+        int ret = avcodec_receive_frame(dec_, frame);
+        if (ret == 0) {
+            decoded_++;
+            if (arrival) {
+                *arrival = last_packet_time_;
+                int64_t pts = frame->best_effort_timestamp != AV_NOPTS_VALUE ? frame->best_effort_timestamp : frame->pts;
+                for (int i = 0; pts != AV_NOPTS_VALUE && i < VIDEO_ARRIVAL_SLOTS; i++) {
+                    if (arrivals_[i].pts == pts) {
+                        *arrival = arrivals_[i].time;
+                        break;
+                    }
+                }
+            }
+            return true;
+        }
+        if (ret != AVERROR(EAGAIN) || draining_) {
+            return false;  // Fin du flux ou erreur de décodage
+        }
+
+        // Le décodeur attend un paquet
+        if (av_read_frame(fmt_, pkt_) < 0) {
+            draining_ = true;
+            avcodec_send_packet(dec_, NULL);  // Vider les images encore retenues par le décodeur
+            continue;
+        }
+        if (pkt_->stream_index == stream_) {
+            last_packet_time_ = monotonic_time();
+            PacketArrival &slot = arrivals_[next_arrival_];
+            slot.pts = pkt_->pts != AV_NOPTS_VALUE ? pkt_->pts : pkt_->dts;
+            slot.time = last_packet_time_;
+            next_arrival_ = (next_arrival_ + 1) % VIDEO_ARRIVAL_SLOTS;
+            avcodec_send_packet(dec_, pkt_);
+        }
+        av_packet_unref(pkt_);
+    }
+}
+
+bool VideoReader::read_luma(Mat &luma) {
+    if (!is_open()) {
+        return false;
+    }
+
+    // L'image précédente (frames_[cur_]) reste référencée pendant le décodage de la suivante
+    cur_ ^= 1;
+    AVFrame *frame = frames_[cur_];
+    if (!decode_next(frame, &arrival_)) {
+        return false;
+    }
+
+    if (luma_plane_usable(frame->format)) {
+        luma = Mat(frame->height, frame->width, CV_8UC1, frame->data[0], (size_t)frame->linesize[0]);
+        return true;
+    }
+
+    // Format sans plan Y exploitable (RGB, 10 bits...) : conversion en gris
+    Mat &gray = gray_[cur_];
+    gray.create(frame->height, frame->width, CV_8UC1);
+    sws_gray_ = sws_getCachedContext(sws_gray_, frame->width, frame->height, (AVPixelFormat)frame->format,
+                                     frame->width, frame->height, AV_PIX_FMT_GRAY8, SWS_BILINEAR, NULL, NULL, NULL);
+    uint8_t *dst[1] = {gray.data};
+    int dst_stride[1] = {(int)gray.step[0]};
+    sws_scale(sws_gray_, frame->data, frame->linesize, 0, frame->height, dst, dst_stride);
+    luma = gray;
+    return true;
+}
+
+void VideoReader::retrieve_bgr(Mat &bgr) {
+    const AVFrame *frame = frames_[cur_];
+    bgr.create(frame->height, frame->width, CV_8UC3);
+    sws_bgr_ = sws_getCachedContext(sws_bgr_, frame->width, frame->height, (AVPixelFormat)frame->format,
+                                    frame->width, frame->height, AV_PIX_FMT_BGR24, SWS_BILINEAR, NULL, NULL, NULL);
+    uint8_t *dst[1] = {bgr.data};
+    int dst_stride[1] = {(int)bgr.step[0]};
+    sws_scale(sws_bgr_, frame->data, frame->linesize, 0, frame->height, dst, dst_stride);
+}
+
+bool VideoReader::motion_vectors(std::vector<BlockMotion> &blocks) const {
+    blocks.clear();
+    const AVFrame *frame = frames_[cur_];
+    const AVFrameSideData *side = frame ? av_frame_get_side_data(frame, AV_FRAME_DATA_MOTION_VECTORS) : nullptr;
+    if (!side) {
+        return false;
+    }
+    const AVMotionVector *mvs = (const AVMotionVector *)side->data;
+    size_t count = side->size / sizeof(AVMotionVector);
+    for (size_t i = 0; i < count; i++) {
+        const AVMotionVector &mv = mvs[i];
+        BlockMotion block;
+        block.x = mv.dst_x - mv.w / 2;  // dst_x, dst_y : centre du bloc dans l'image courante
+        block.y = mv.dst_y - mv.h / 2;
+        block.w = mv.w;
+        block.h = mv.h;
+        float scale = mv.motion_scale > 0 ? (float)mv.motion_scale : 1.0f;
+        block.dx = mv.motion_x / scale;
+        block.dy = mv.motion_y / scale;
+        blocks.push_back(block);
+    }
+    return true;
+}
+
+bool VideoReader::frame_is_intra() const {
+    const AVFrame *frame = frames_[cur_];
+    return frame && frame->pict_type == AV_PICTURE_TYPE_I;
+}
+
+bool VideoReader::grab() {
+    if (!is_open() || !decode_next(grabbed_)) {
+        return false;
+    }
+    av_frame_unref(grabbed_);
+    return true;
+}
+
+void VideoReader::set_skip_nonref(bool skip) {
+    if (dec_) {
+        dec_->skip_frame = skip ? AVDISCARD_NONREF : AVDISCARD_DEFAULT;
+    }
+}
+
+int64_t VideoReader::frame_number() const {
+    const AVFrame *frame = frames_[cur_];
+    double rate = fps();
+    if (frame && frame->best_effort_timestamp != AV_NOPTS_VALUE && rate > 0) {
+        const AVStream *st = fmt_->streams[stream_];
+        int64_t start = st->start_time != AV_NOPTS_VALUE ? st->start_time : 0;
+        return llrint((frame->best_effort_timestamp - start) * av_q2d(st->time_base) * rate);
+    }
+    return decoded_ - 1;  // Sans horodatage : images effectivement décodées
+}
+
+int VideoReader::width() const {
+    return dec_ ? dec_->width : 0;
+}
+
+int VideoReader::height() const {
+    return dec_ ? dec_->height : 0;
+}
+
+double VideoReader::fps() const {
+    return fmt_ ? av_q2d(fmt_->streams[stream_]->avg_frame_rate) : 0.0;
+}
+
+double VideoReader::duration() const {
+    if (!fmt_) {
+        return 0.0;
+    }
+    const AVStream *st = fmt_->streams[stream_];
+    if (st->duration != AV_NOPTS_VALUE) {
+        return st->duration * av_q2d(st->time_base);
+    }
+    return fmt_->duration != AV_NOPTS_VALUE ? (double)fmt_->duration / AV_TIME_BASE : 0.0;
+}
+
+const IoStats *VideoReader::io_stats() const {
+    return input_ ? &input_->stats() : nullptr;
+}
+
+int64_t VideoReader::frame_count() const {
+    if (!fmt_) {
+        return 0;
+    }
+    const AVStream *st = fmt_->streams[stream_];
+    if (st->nb_frames > 0) {
+        return st->nb_frames;
+    }
+    return llrint(duration() * fps());
+}
+
+int64_t VideoReader::pts() const {
+    return frames_[cur_] ? frames_[cur_]->best_effort_timestamp : AV_NOPTS_VALUE;
+}
+
+double VideoReader::time_base() const {
+    return fmt_ ? av_q2d(fmt_->streams[stream_]->time_base) : 0.0;
+}
+
+std::vector<int64_t> VideoReader::keyframes() {
+    std::vector<int64_t> keys;
+    if (!fmt_) {
+        return keys;
+    }
+
+    AVStream *st = fmt_->streams[stream_];
+    int count = avformat_index_get_entries_count(st);
+    for (int i = 0; i < count; i++) {
+        const AVIndexEntry *entry = avformat_index_get_entry(st, i);
+        if (entry && (entry->flags & AVINDEX_KEYFRAME)) {
+            keys.push_back(entry->timestamp);
+        }
+    }
+    if (!keys.empty()) {
+        return keys;
+    }
+
+    // Pas d'index (flux MPEG-TS, MKV sans cues...) : parcourir les paquets sans les décoder
+    while (av_read_frame(fmt_, pkt_) >= 0) {
+        if (pkt_->stream_index == stream_ && (pkt_->flags & AV_PKT_FLAG_KEY) && pkt_->pts != AV_NOPTS_VALUE) {
+            keys.push_back(pkt_->pts);
+        }
+        av_packet_unref(pkt_);
+    }
+    seek(st->start_time != AV_NOPTS_VALUE ? st->start_time : 0);
+    return keys;
+}
+
+bool VideoReader::seek(int64_t pts) {
+    if (!fmt_ || av_seek_frame(fmt_, stream_, pts, AVSEEK_FLAG_BACKWARD) < 0) {
+        return false;
+    }
+    avcodec_flush_buffers(dec_);
+    av_frame_unref(frames_[0]);
+    av_frame_unref(frames_[1]);
+    draining_ = false;
+    decoded_ = 0;
+    forget_arrivals();  // Les mêmes horodatages vont revenir
+    return true;
+}
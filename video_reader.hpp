@@ -0,0 +1,147 @@
+#ifndef VIDEO_READER_HPP
+#define VIDEO_READER_HPP
+
+// Lecteur vidéo FFmpeg qui décode directement vers le plan de luminance.
+//
+// VideoCapture::read décode en YUV, convertit en BGR, puis le détecteur
+// reconvertit en gris. Ici le plan Y du décodeur est transmis tel quel au
+// détecteur (sans copie) et la conversion BGR n'est faite que pour les images
+// réellement annotées ou affichées.
+
+#include <opencv2/opencv.hpp>
+#include <stdint.h>
+#include <vector>
+
+#include "video_io.hpp"
+
+#define VIDEO_ARRIVAL_SLOTS 64  // Paquets dont l'heure de lecture est gardée (images retenues par le décodeur)
+
+struct AVFormatContext;
+struct AVIOContext;
+struct AVCodecContext;
+struct AVPacket;
+struct AVFrame;
+struct SwsContext;
+
+// Vecteur de mouvement d'un bloc de l'image courante, exporté par le décodeur (H.264, MPEG-4...)
+struct BlockMotion {
+    int x, y;        // Coin haut gauche du bloc dans l'image courante
+    int w, h;
+    float dx, dy;    // Déplacement depuis l'image de référence (pixels)
+};
+
+class VideoReader {
+public:
+    VideoReader();
+    ~VideoReader();
+    VideoReader(const VideoReader &) = delete;
+    VideoReader &operator=(const VideoReader &) = delete;
+
+    // Threads de décodage des lecteurs ouverts ensuite (0 : choisi par FFmpeg, un par cœur).
+    // Fixé par le budget de threads (cf. thread_budget.hpp) pour ne pas multiplier les threads.
+    static void set_default_threads(int threads);
+
+    // true : le décodeur exporte les vecteurs de mouvement des lecteurs ouverts ensuite
+    // (AV_CODEC_FLAG2_EXPORT_MVS) ; le décodage reste complet, déblocage compris
+    void set_export_motion_vectors(bool enable) { export_mvs_ = enable; }
+
+    // > 0 : suivre un fichier encore en cours d'écriture (protocole file de FFmpeg, option
+    // follow) : en fin de fichier, la lecture attend de nouvelles données et ne s'arrête
+    // qu'après timeout secondes sans croissance. Le décodeur est réglé pour une faible
+    // latence (pas de threads par image, qui retardent chaque image d'autant d'images).
+    void set_follow(double timeout) { follow_timeout_ = timeout; }
+
+    bool open(const char *path);
+    bool is_open() const { return fmt_ != nullptr; }
+    void close();
+
+    // Décode l'image suivante et expose son plan de luminance (CV_8UC1).
+    // Pour les formats YUV/NV12 8 bits, luma pointe directement dans le tampon du
+    // décodeur. L'image précédente reste valide jusqu'à l'appel suivant, ce qui
+    // permet au détecteur de la garder comme référence sans la copier.
+    bool read_luma(cv::Mat &luma);
+
+    // Convertit la dernière image décodée en BGR (annotation ou affichage seulement)
+    void retrieve_bgr(cv::Mat &bgr);
+
+    // Vecteurs de mouvement de la dernière image lue (tampon réutilisé) ; false si le
+    // décodeur n'en a pas exporté (image intra, codec sans vecteurs, export désactivé)
+    bool motion_vectors(std::vector<BlockMotion> &blocks) const;
+
+    // true si la dernière image lue est une image intra (aucun vecteur de mouvement)
+    bool frame_is_intra() const;
+
+    // Décode l'image suivante sans l'exposer (équivalent de grab() sans retrieve()) :
+    // ni plan Y, ni conversion. L'image de la dernière lecture read_luma reste valide.
+    bool grab();
+
+    // true : le décodeur ignore les images non référencées (images B), qui ne sont
+    // alors ni décodées ni retournées. Pour l'échantillonnage des périodes calmes.
+    void set_skip_nonref(bool skip);
+
+    // Numéro de la dernière image lue par read_luma, d'après son horodatage (images sautées comprises)
+    int64_t frame_number() const;
+
+    // Heure (CLOCK_MONOTONIC, comme wall_time) de la lecture du paquet de la dernière image lue
+    // par read_luma : mesure de latence depuis l'arrivée des données, attente du démultiplexeur
+    // et délai du décodeur compris. À défaut de paquet retrouvé (horodatage absent), heure du
+    // dernier paquet lu.
+    double arrival() const { return arrival_; }
+
+    int width() const;
+    int height() const;
+    double fps() const;
+    double duration() const;  // Durée du flux vidéo en secondes (0 si inconnue)
+    int64_t frame_count() const;  // Nombre d'images d'après le conteneur (ou durée x fps), sans décodage
+
+    // Octets lus et attente des entrées/sorties depuis l'ouverture ; NULL avec le protocole
+    // file de FFmpeg (IO_DEFAULT, suivi d'un fichier, entrée qui n'est pas un fichier)
+    const IoStats *io_stats() const;
+
+    // Horodatage (pts, en unités de time_base()) de la dernière image décodée
+    int64_t pts() const;
+    double time_base() const;  // Secondes par unité de pts
+
+    // Horodatages des images clés du flux, depuis l'index du conteneur
+    // (ou par un parcours des paquets sans décodage si l'index est vide)
+    std::vector<int64_t> keyframes();
+
+    // Se place sur l'image clé précédant ou égale à pts ; les lectures suivantes
+    // repartent de cette image clé
+    bool seek(int64_t pts);
+
+private:
+    // Heure de lecture des derniers paquets, retrouvée par horodatage à la sortie du décodeur
+    struct PacketArrival {
+        int64_t pts;
+        double time;
+    };
+
+    bool decode_next(AVFrame *frame, double *arrival = nullptr);
+    void forget_arrivals();
+
+    AVFormatContext *fmt_;
+    AVIOContext *avio_;   // Contexte AVIO personnalisé (cf. video_io.hpp), NULL avec le protocole file
+    VideoInput *input_;
+    AVCodecContext *dec_;
+    AVPacket *pkt_;
+    AVFrame *frames_[2];  // Image courante et image précédente (références conservées)
+    AVFrame *grabbed_;    // Image décodée par grab(), libérée aussitôt
+    int cur_;
+    int64_t decoded_;     // Images décodées depuis l'ouverture ou le dernier seek
+    int stream_;
+    bool draining_;
+    bool export_mvs_;
+    double follow_timeout_;
+    SwsContext *sws_gray_;
+    SwsContext *sws_bgr_;
+    cv::Mat gray_[2];     // Plan Y recopié pour les formats non utilisables directement
+    PacketArrival arrivals_[VIDEO_ARRIVAL_SLOTS];  // Tampon circulaire (retard du décodeur borné)
+    int next_arrival_;
+    double last_packet_time_;
+    double arrival_;
+
+    static int default_threads_;
+};
+
+#endif // VIDEO_READER_HPP
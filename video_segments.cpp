@@ -0,0 +1,254 @@
+#include "video_segments.hpp"
+#include "alloc_counter.hpp"
+#include "result_cache.hpp"
+#include "video_io.hpp"
+#include "video_reader.hpp"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string>
+
+using namespace cv;
+using namespace std;
+
+vector<VideoSegment> split_video(const char *video_path, int max_segments, double min_seconds) {
+    vector<VideoSegment> segments;
+    segments.push_back(VideoSegment{SEGMENT_FROM_START, SEGMENT_TO_END});
+
+    VideoReader reader;
+    if (max_segments <= 1 || !reader.open(video_path)) {
+        return segments;
+    }
+
+    double duration = reader.duration();
+    double time_base = reader.time_base();
+    int count = min_seconds > 0 ? (int)(duration / min_seconds) : max_segments;
+    if (count > max_segments) {
+        count = max_segments;
+    }
+    if (count <= 1 || time_base <= 0) {
+        return segments;
+    }
+
+    vector<int64_t> keys = reader.keyframes();
+    if (keys.size() < 2) {
+        return segments;
+    }
+
+    // Frontière i : première image clé après i/count de la durée
+    int64_t first_pts = keys.front();
+    size_t k = 1;
+    for (int i = 1; i < count; i++) {
+        int64_t target = first_pts + (int64_t)(duration * i / count / time_base);
+        while (k < keys.size() && keys[k] < target) {
+            k++;
+        }
+        if (k >= keys.size()) {
+            break;
+        }
+        segments.back().end_pts = keys[k];
+        segments.push_back(VideoSegment{keys[k], SEGMENT_TO_END});
+        k++;
+    }
+    return segments;
+}
+
+bool segments_supported(const MotionConfig &config, const char **reason) {
+    const char *why = nullptr;
+    if (config.sample_every > 1) {
+        why = "--sample";  // L'échantillonnage dépend des images analysées avant chaque frontière
+    } else if (config.backend != BACKEND_PIXELS) {
+        why = "--backend";
+    } else if (alloc_counter_enabled()) {
+        why = "--alloc-stats";
+    } else if (io_stats_enabled()) {
+        why = "--io-stats";
+    } else if (result_cache()) {
+        why = "--cache";
+    }
+    if (reason) {
+        *reason = why;
+    }
+    return why == nullptr;
+}
+
+bool analyse_segment(const char *video_path, const VideoSegment &segment, const MotionConfig &config,
+                     segment_result_fn on_result, void *arg) {
+    VideoReader reader;
+    if (!reader.open(video_path)) {
+        return false;
+    }
+    const bool from_start = segment.start_pts == SEGMENT_FROM_START;
+    if (!from_start && !reader.seek(segment.start_pts)) {
+        return false;
+    }
+
+    MotionDetector detector(config);
+    Mat luma;
+    FrameResult result;
+    bool first = true;
+
+    while (reader.read_luma(luma)) {
+        int64_t pts = reader.pts();
+        if (!from_start && first && pts < segment.start_pts) {
+            continue;  // Image antérieure à l'image clé (GOP ouvert) : couverte par le segment précédent
+        }
+        if (pts > segment.end_pts) {
+            break;  // Au-delà de l'image de recouvrement
+        }
+
+        detector.process_luma(luma, result);
+        if (first && !from_start) {
+            first = false;
+            continue;  // L'image clé de début sert seulement de référence
+        }
+        first = false;
+
+        result.contours = nullptr;  // Les contours appartiennent à l'extracteur du segment
+        if (!on_result(arg, result)) {
+            break;
+        }
+    }
+    return true;
+}
+
+// Vidéo en cours de traitement par segments. Les résultats du segment en tête (le plus
+// ancien pas encore transmis) vont directement à la sortie ; seuls ceux des segments
+// suivants, terminés ou en cours, attendent leur tour en mémoire.
+struct SegmentedVideo {
+    string path;
+    MotionConfig config;
+    MotionSink *sink;
+    ThreadPool *pool;
+    double min_segment_seconds;
+    vector<VideoSegment> segments;
+    vector<vector<FrameResult>> pending;  // Résultats en attente, par segment
+    vector<bool> done;
+    size_t head;          // Segment dont les résultats sont transmis au fil de l'eau
+    int frame_index;      // Numéro de la prochaine image transmise
+    bool movement_detected;
+    bool stopped;         // Sortie arrêtée (sink->on_frame faux ou stop_at_first)
+    bool failed;
+    int remaining;        // Segments pas encore terminés
+    pthread_mutex_t lock;
+};
+
+struct SegmentJob {
+    SegmentedVideo *video;
+    int index;
+};
+
+// Transmet un résultat à la sortie (verrou de la vidéo tenu)
+static void emit_result(SegmentedVideo *video, FrameResult &result) {
+    if (video->stopped) {
+        return;
+    }
+    Mat no_frame;  // La sortie ne reçoit pas d'image BGR (en-tête vide, sans allocation)
+    result.frame_index = video->frame_index++;
+    bool moved = result.movement_pixels > 0;
+    video->movement_detected = video->movement_detected || moved;
+    if ((video->sink && !video->sink->on_frame(video->path.c_str(), no_frame, result)) ||
+        (moved && video->config.stop_at_first)) {
+        video->stopped = true;
+    }
+}
+
+// Transmet les résultats en attente du segment de tête, puis passe aux segments suivants
+// déjà terminés (verrou de la vidéo tenu)
+static void flush_head(SegmentedVideo *video) {
+    while (video->head < video->segments.size()) {
+        vector<FrameResult> &pending = video->pending[video->head];
+        for (size_t i = 0; i < pending.size(); i++) {
+            emit_result(video, pending[i]);
+        }
+        vector<FrameResult>().swap(pending);
+        if (!video->done[video->head]) {
+            break;  // Segment en cours : ses prochains résultats iront directement à la sortie
+        }
+        video->head++;
+    }
+}
+
+static bool segment_result(void *arg, const FrameResult &result) {
+    SegmentJob *job = (SegmentJob *)arg;
+    SegmentedVideo *video = job->video;
+    pthread_mutex_lock(&video->lock);
+    if ((size_t)job->index == video->head) {
+        flush_head(video);  // Résultats mis en attente avant que le segment passe en tête
+        FrameResult copy = result;
+        emit_result(video, copy);
+    } else {
+        video->pending[job->index].push_back(result);
+    }
+    bool keep_going = !video->stopped;
+    pthread_mutex_unlock(&video->lock);
+    return keep_going;
+}
+
+static void *segment_job(void *arg) {
+    SegmentJob *job = (SegmentJob *)arg;
+    SegmentedVideo *video = job->video;
+
+    bool ok = analyse_segment(video->path.c_str(), video->segments[job->index], video->config, segment_result, job);
+
+    pthread_mutex_lock(&video->lock);
+    video->done[job->index] = true;
+    video->failed = video->failed || !ok;
+    if ((size_t)job->index == video->head) {
+        flush_head(video);
+    }
+    bool last = --video->remaining == 0;
+    pthread_mutex_unlock(&video->lock);
+    delete job;
+
+    if (last) {
+        // Tous les segments sont terminés : la tête a dépassé le dernier
+        if (video->failed) {
+            fprintf(stderr, "Erreur lors de l'ouverture de la vidéo %s\n", video->path.c_str());
+        }
+        if (video->sink) {
+            video->sink->end_video(video->path.c_str(), video->movement_detected);
+        }
+        pthread_mutex_destroy(&video->lock);
+        delete video;
+    }
+    return NULL;
+}
+
+// Premier job d'une vidéo : découpage, puis un job par segment dans la file du worker courant
+static void *split_job(void *arg) {
+    SegmentedVideo *video = (SegmentedVideo *)arg;
+    video->segments = split_video(video->path.c_str(), video->pool->size(), video->min_segment_seconds);
+    video->pending.resize(video->segments.size());
+    video->done.assign(video->segments.size(), false);
+    video->remaining = (int)video->segments.size();
+
+    if (video->segments.size() > 1) {
+        printf("Vidéo %s découpée en %zu segments\n", video->path.c_str(), video->segments.size());
+    }
+    if (video->sink) {
+        video->sink->begin_video(video->path.c_str());
+    }
+    for (size_t i = 0; i < video->segments.size(); i++) {
+        video->pool->submit(segment_job, new SegmentJob{video, (int)i});
+    }
+    return NULL;
+}
+
+void submit_segmented_video(ThreadPool &pool, const char *video_path, const MotionConfig &config,
+                            MotionSink *sink, double min_segment_seconds) {
+    SegmentedVideo *video = new SegmentedVideo;
+    video->path = video_path;
+    video->config = config;
+    video->sink = sink;
+    video->pool = &pool;
+    video->min_segment_seconds = min_segment_seconds;
+    video->head = 0;
+    video->frame_index = 0;
+    video->movement_detected = false;
+    video->stopped = false;
+    video->failed = false;
+    video->remaining = 0;
+    pthread_mutex_init(&video->lock, NULL);
+    pool.submit(split_job, video);
+}
@@ -0,0 +1,52 @@
+#ifndef VIDEO_SEGMENTS_HPP
+#define VIDEO_SEGMENTS_HPP
+
+// Parallélisme à l'intérieur d'une vidéo.
+//
+// Une longue vidéo est découpée aux images clés en segments décodés et analysés
+// en parallèle sur le pool de threads. Chaque segment décode en plus la première
+// image du segment suivant (image de recouvrement) : la différence avec l'image
+// précédente à chaque frontière n'est donc pas perdue. Les résultats des segments
+// sont transmis dans l'ordre des images, comme pour un traitement séquentiel.
+
+#include "motion_engine.hpp"
+#include "thread_pool.hpp"
+
+#include <stdint.h>
+#include <vector>
+
+#define SEGMENT_FROM_START INT64_MIN  // Segment qui commence au début du fichier (sans seek)
+#define SEGMENT_TO_END INT64_MAX      // Segment qui va jusqu'à la fin du fichier
+
+struct VideoSegment {
+    int64_t start_pts;  // Image clé de début (SEGMENT_FROM_START pour le premier segment)
+    int64_t end_pts;    // Première image du segment suivant, traitée comme recouvrement
+};
+
+// Découpe une vidéo en au plus max_segments segments alignés sur les images clés,
+// d'au moins min_seconds chacun. Une vidéo courte ou sans index donne un seul segment.
+std::vector<VideoSegment> split_video(const char *video_path, int max_segments, double min_seconds);
+
+// Segments utilisables avec cette configuration et ces options ? Sinon reason reçoit l'option
+// en cause : l'échantillonnage et le backend par vecteurs ne sont appliqués que par run_video,
+// comme les statistiques d'allocations et d'entrées et le cache des résultats.
+bool segments_supported(const MotionConfig &config, const char **reason);
+
+// Reçoit chaque résultat d'un segment, dans l'ordre ; retourne false pour arrêter le segment
+typedef bool (*segment_result_fn)(void *arg, const FrameResult &result);
+
+// Analyse un segment ; on_result reçoit un résultat par image propre au segment
+// (l'image clé de début, déjà couverte par le segment précédent, est exclue).
+// Retourne false si la vidéo ne peut pas être ouverte.
+bool analyse_segment(const char *video_path, const VideoSegment &segment, const MotionConfig &config,
+                     segment_result_fn on_result, void *arg);
+
+// Soumet une vidéo au pool : elle est découpée par un premier job, chaque segment
+// devient un job (volable par les autres workers). Les résultats sont transmis à sink
+// dans l'ordre des images au fil de l'analyse : ceux du plus ancien segment non terminé
+// directement, ceux des segments suivants quand vient leur tour.
+// La sortie ne reçoit pas d'image BGR (sink->wants_frame() est ignoré).
+void submit_segmented_video(ThreadPool &pool, const char *video_path, const MotionConfig &config,
+                            MotionSink *sink, double min_segment_seconds);
+
+#endif // VIDEO_SEGMENTS_HPP